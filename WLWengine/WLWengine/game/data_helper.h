@@ -2,6 +2,7 @@
 
 #include <vector>
 #include "core/mesh.h"
+#include "core/mesh_optimizer.h"
 #include "core/vertex_3d.h"
 
 using namespace wlw;
@@ -124,8 +125,9 @@ inline std::shared_ptr<core::Mesh<core::Vertex3D>> createPyramidFrustumWithNorma
   }
 
   auto mesh_ = std::make_shared<core::Mesh<core::Vertex3D>>();
-  mesh_->SetVertices(vertices);
-  mesh_->SetIndices(indices);
+  core::WeldVertices(vertices, indices);
+  mesh_->SetVertices(std::move(vertices));
+  mesh_->SetIndices(std::move(indices));
   return mesh_;
 }
 
@@ -200,8 +202,9 @@ inline std::shared_ptr<core::Mesh<core::Vertex3D>> createCubeWithNormals(float s
   }
 
   auto mesh_ = std::make_shared<core::Mesh<core::Vertex3D>>();
-  mesh_->SetVertices(vertices);
-  mesh_->SetIndices(indices);
+  core::WeldVertices(vertices, indices);
+  mesh_->SetVertices(std::move(vertices));
+  mesh_->SetIndices(std::move(indices));
   return mesh_;
 }
 
@@ -294,8 +297,9 @@ inline std::shared_ptr<core::Mesh<core::Vertex3D>> createSphereWithNormals(
 
   // --- 3. Package and Return ---
   auto mesh_ = std::make_shared<core::Mesh<core::Vertex3D>>();
-  mesh_->SetVertices(vertices);
-  mesh_->SetIndices(indices);
+  core::WeldVertices(vertices, indices);
+  mesh_->SetVertices(std::move(vertices));
+  mesh_->SetIndices(std::move(indices));
   return mesh_;
   }
 
@@ -346,8 +350,9 @@ inline std::shared_ptr<core::Mesh<core::Vertex3D>> createSphereWithNormals(
   }
 
   auto mesh_ = std::make_shared<core::Mesh<core::Vertex3D>>();
-  mesh_->SetVertices(vertices);
-  mesh_->SetIndices(indices);
+  core::WeldVertices(vertices, indices);
+  mesh_->SetVertices(std::move(vertices));
+  mesh_->SetIndices(std::move(indices));
   return mesh_;
   }
 
@@ -379,7 +384,8 @@ inline std::shared_ptr<core::Mesh<core::Vertex3D>> createSphereWithNormals(
   for (size_t i = 0; i < vertices.size(); ++i) indices[i] = (uint32_t)i;
 
   auto mesh_ = std::make_shared<core::Mesh<core::Vertex3D>>();
-  mesh_->SetVertices(vertices);
-  mesh_->SetIndices(indices);
+  core::WeldVertices(vertices, indices);
+  mesh_->SetVertices(std::move(vertices));
+  mesh_->SetIndices(std::move(indices));
   return mesh_;
   }
\ No newline at end of file
@@ -2,8 +2,10 @@
 #include "player_controller.h"
 #include "level.h"
 #include "../root/scene/follow_camera.h"
+#include <algorithm>
 #include <iostream>
 #include <vector>
+#include <random>
 #include <string>
 
 namespace wlw::game {
@@ -17,6 +19,7 @@ namespace wlw::game {
 
     void Initialize() override {
       engine_->Start(window_);
+      engine_->SetThreadedRendering(true);
       SwitchLevel(0);
     }
 
@@ -93,7 +96,10 @@ namespace wlw::game {
       }
 
       current_light_ = light;
-      level_data_ = level_loader.Load(map, window_, light);
+      window_->ClearLights();
+      window_->AddLight(light);
+      stress_light_ids_.clear();
+      level_data_ = level_loader.Load(map, window_);
       
       if (level_data_.player_node) {
         player_controller_ = std::make_unique<PlayerController>(level_data_.player_node, level_data_.static_colliders);
@@ -119,6 +125,53 @@ namespace wlw::game {
         l_pressed = false;
       }
 
+      // Toggle the depth pre-pass with 'P' to A/B it on the point and spot light levels
+      static bool p_pressed = false;
+      if (glfwGetKey(glfw_win, GLFW_KEY_P) == GLFW_PRESS) {
+        if (!p_pressed) {
+          auto driver = engine_->GetRenderingDriver();
+          driver->SetDepthPrePassEnabled(!driver->IsDepthPrePassEnabled());
+          std::cout << "Depth pre-pass: " << (driver->IsDepthPrePassEnabled() ? "on" : "off") << "\n";
+          p_pressed = true;
+        }
+      } else {
+        p_pressed = false;
+      }
+
+      // Toggle the periodic per-pass GPU timing log with 'T'
+      static bool t_pressed = false;
+      if (glfwGetKey(glfw_win, GLFW_KEY_T) == GLFW_PRESS) {
+        if (!t_pressed) {
+          gpu_timing_log_ = !gpu_timing_log_;
+          engine_->GetRenderingDriver()->SetGpuTimingLogEnabled(gpu_timing_log_);
+          t_pressed = true;
+        }
+      } else {
+        t_pressed = false;
+      }
+
+      // Cycle vsync / adaptive / 144 fps cap / uncapped with 'V' and print how evenly frames were presented
+      static bool v_pressed = false;
+      if (glfwGetKey(glfw_win, GLFW_KEY_V) == GLFW_PRESS) {
+        if (!v_pressed) {
+          CyclePresentMode();
+          v_pressed = true;
+        }
+      } else {
+        v_pressed = false;
+      }
+
+      // Toggle 256 small point / spot lights with 'K' to stress the clustered lighting
+      static bool k_pressed = false;
+      if (glfwGetKey(glfw_win, GLFW_KEY_K) == GLFW_PRESS) {
+        if (!k_pressed) {
+          ToggleStressLights();
+          k_pressed = true;
+        }
+      } else {
+        k_pressed = false;
+      }
+
       if (player_controller_) {
         player_controller_->Update(glfw_win);
         
@@ -145,14 +198,55 @@ namespace wlw::game {
       }
     }
 
+    void CyclePresentMode() {
+      auto timing = engine_->GetFrameTiming();
+      std::cout << rendering::GetPresentModeName(engine_->GetPresentMode()) << ": " << timing.average_milliseconds
+                << " ms/frame, jitter " << timing.jitter_milliseconds << " ms (min " << timing.min_milliseconds
+                << ", max " << timing.max_milliseconds << ")\n";
+
+      auto mode = (rendering::PresentMode)(((int)engine_->GetPresentMode() + 1) % 4);
+      engine_->SetPresentMode(mode, 144.0f);
+      std::cout << "Present mode: " << rendering::GetPresentModeName(mode) << "\n";
+    }
+
+    void ToggleStressLights() {
+      if (!stress_light_ids_.empty()) {
+        for (int id : stress_light_ids_) {
+          window_->RemoveLight(id);
+        }
+        stress_light_ids_.clear();
+        std::cout << "Stress lights: off\n";
+        return;
+      }
+
+      std::mt19937 rng(1234);
+      std::uniform_real_distribution<float> tile(0.0f, 9.0f);
+      std::uniform_real_distribution<float> channel(0.2f, 1.0f);
+      for (int i = 0; i < 256; ++i) {
+        auto light = std::make_shared<rendering::Lighting>();
+        light->type = (i % 4 == 0) ? rendering::LightType::Spot : rendering::LightType::Point;
+        light->position = {tile(rng), (i % 4 == 0) ? 2.0f : 0.6f, tile(rng)};
+        light->direction = {0.0f, -1.0f, 0.0f};
+        light->color = {channel(rng), channel(rng), channel(rng), 1.0f};
+        light->ambient_strength = 0.0f;
+        light->range = 1.5f;
+        stress_light_ids_.push_back(window_->AddLight(light));
+      }
+      std::cout << "Stress lights: " << stress_light_ids_.size() << "\n";
+    }
+
     void Render() override {
       engine_->Iterate();
     }
 
     void Run() override {
       Initialize();
+      float last_time = (float)glfwGetTime();
       while (true) {
-        Update(0.016f);
+        float current_time = (float)glfwGetTime();
+        float dt = std::min(current_time - last_time, 0.1f); // Cap dt for stability
+        last_time = current_time;
+        Update(dt);
         Render();
       }
     }
@@ -163,6 +257,8 @@ namespace wlw::game {
     std::unique_ptr<PlayerController> player_controller_;
     std::shared_ptr<scene::Camera3D> camera_;
     std::shared_ptr<rendering::Lighting> current_light_;
+    std::vector<int> stress_light_ids_;
+    bool gpu_timing_log_ = false;
     LevelResult level_data_;
     int current_level_idx_ = 0;
     int score_ = 0;
@@ -2,47 +2,45 @@
 #include "data_helper.h"
 #include "../root/utils/gltf_loader.h"
 #include "../root/rendering/material.h"
+#include "../root/core/grid_mesher.h"
+#include <algorithm>
 #include <map>
 
 namespace wlw::game {
 
-LevelResult Level::Load(const std::vector<std::string>& map_data, std::shared_ptr<scene::Window> window, std::shared_ptr<rendering::Lighting> light) {
+LevelResult Level::Load(const std::vector<std::string>& map_data, std::shared_ptr<scene::Window> window) {
   LevelResult result;
   result.player_start_pos = {0.0f, 0.0f, 0.0f};
 
   // Materials
   std::shared_ptr<rendering::Material> wall_material = rendering::Material::Create();
-  wall_material->SetLighting(*light);
+  wall_material->SetLit(true);
   core::Color wall_color = {0.3f, 0.3f, 0.3f, 1.0f};
 
   std::shared_ptr<rendering::Material> floor_material = rendering::Material::Create();
-  floor_material->SetLighting(*light);
+  floor_material->SetLit(true);
   core::Color floor_color_1 = {0.4f, 0.4f, 0.4f, 1.0f};
   core::Color floor_color_2 = {0.5f, 0.5f, 0.5f, 1.0f};
 
   std::shared_ptr<rendering::Material> collectible_material = rendering::Material::Create();
-  collectible_material->SetLighting(*light);
+  collectible_material->SetLit(true);
   core::Color collectible_color = {1.0f, 0.8f, 0.0f, 1.0f}; // Gold
 
   // Meshes & Models
-  auto wall_mesh = createCubeWithNormals(1.0f, wall_color);
-  auto floor_mesh_1 = createCubeWithNormals(1.0f, floor_color_1);
-  auto floor_mesh_2 = createCubeWithNormals(1.0f, floor_color_2);
   auto sphere_mesh = createSphereWithNormals(0.3f); 
 
-  auto wall_model = std::make_shared<core::Model<core::Vertex3D>>();
-  wall_model->meshes.push_back(wall_mesh);
-
-  auto floor_model_1 = std::make_shared<core::Model<core::Vertex3D>>();
-  floor_model_1->meshes.push_back(floor_mesh_1);
-
-  auto floor_model_2 = std::make_shared<core::Model<core::Vertex3D>>();
-  floor_model_2->meshes.push_back(floor_mesh_2);
-
   auto collectible_mesh = createGemWithNormals(0.4f, 0.6f); 
   auto collectible_model = std::make_shared<core::Model<core::Vertex3D>>();
   collectible_model->meshes.push_back(collectible_mesh);
 
+  // Walls and floors are tile grids: one cell per tile, cell type 1 for walls and 1 / 2 for the floor checkerboard.
+  int width = 0;
+  for (const auto& row : map_data) {
+    width = std::max(width, (int)row.size());
+  }
+  core::CellGrid wall_grid(width, 1, (int)map_data.size());
+  core::CellGrid floor_grid(width, 1, (int)map_data.size());
+
   // Parsing
   for (int z = 0; z < map_data.size(); ++z) {
     for (int x = 0; x < map_data[z].size(); ++x) {
@@ -50,22 +48,12 @@ LevelResult Level::Load(const std::vector<std::string>& map_data, std::shared_pt
       core::Vector3 pos = {(float)x, 0.0f, (float)z};
 
       if (tile != '#') {
-        auto floor_node = std::make_shared<scene::Node3D>();
-        floor_node->SetModel((x + z) % 2 == 0 ? floor_model_1 : floor_model_2);
-        floor_node->SetMaterial(floor_material);
-        floor_node->SetScale({1.0f, 0.1f, 1.0f});
-        floor_node->SetPosition({pos.x, -0.05f, pos.z});
-        window->AddNode(floor_node);
+        floor_grid.Set(x, 0, z, (x + z) % 2 == 0 ? 1 : 2);
       }
 
       if (tile == '#') {
-        auto wall_node = std::make_shared<scene::Node3D>();
-        wall_node->SetModel(wall_model);
-        wall_node->SetMaterial(wall_material);
-        wall_node->SetScale({1.0f, 1.0f, 1.0f});
-        wall_node->SetPosition({pos.x, 0.5f, pos.z});
-        window->AddNode(wall_node);
-        result.static_colliders.push_back(scene::AABB::FromPositionAndScale(wall_node->GetPosition(), wall_node->GetScale()));
+        wall_grid.Set(x, 0, z, 1);
+        result.static_colliders.push_back(scene::AABB::FromPositionAndScale({pos.x, 0.5f, pos.z}, {1.0f, 1.0f, 1.0f}));
       } else if (tile == 'P') {
         result.player_start_pos = {pos.x, 0.5f, pos.z};
         auto player_mesh = createCubeWithNormals(0.6f, {0.0f, 0.4f, 0.8f, 1.0f}); // Blue cube
@@ -76,7 +64,7 @@ LevelResult Level::Load(const std::vector<std::string>& map_data, std::shared_pt
         result.player_node->SetModel(player_model);
         
         std::shared_ptr<rendering::Material> player_material = rendering::Material::Create();
-        player_material->SetLighting(*light);
+        player_material->SetLit(true);
         result.player_node->SetMaterial(player_material);
         
         result.player_node->SetPosition(result.player_start_pos);
@@ -94,6 +82,34 @@ LevelResult Level::Load(const std::vector<std::string>& map_data, std::shared_pt
     }
   }
 
+  // Hidden faces are dropped and flat runs merged, then each chunk goes to the batcher as one node per grid.
+  result.static_geometry = std::make_shared<scene::StaticBatcher>();
+  auto add_grid = [&](const core::CellGrid& grid, const core::GridMeshSettings& settings, const core::Vector3& origin,
+                      std::shared_ptr<rendering::Material> material) {
+    int chunk_cells = (int)scene::StaticBatcher::kDefaultChunkSize;
+    for (const auto& chunk : core::BuildGridMeshChunks(grid, settings, chunk_cells)) {
+      auto model = std::make_shared<core::Model<core::Vertex3D>>();
+      model->meshes.push_back(chunk.mesh);
+      auto node = std::make_shared<scene::Node3D>();
+      node->SetModel(model);
+      node->SetMaterial(material);
+      node->SetPosition({origin.x + chunk.box.min[0] * settings.cell_size.x,
+                         origin.y + chunk.box.min[1] * settings.cell_size.y,
+                         origin.z + chunk.box.min[2] * settings.cell_size.z});
+      result.static_geometry->Add(node);
+    }
+  };
+
+  core::GridMeshSettings wall_settings;
+  wall_settings.colors = {{}, wall_color};
+  add_grid(wall_grid, wall_settings, {-0.5f, 0.0f, -0.5f}, wall_material);
+
+  core::GridMeshSettings floor_settings;
+  floor_settings.cell_size = {1.0f, 0.1f, 1.0f};
+  floor_settings.colors = {{}, floor_color_1, floor_color_2};
+  add_grid(floor_grid, floor_settings, {-0.5f, -0.1f, -0.5f}, floor_material);
+
+  result.static_geometry->Build(*window);
   return result;
 }
 
@@ -5,6 +5,7 @@
 #include <map>
 #include "scene/window.h"
 #include "scene/node.h"
+#include "scene/static_batcher.h"
 #include "core/collision.h"
 
 namespace wlw::game {
@@ -14,11 +15,12 @@ struct LevelResult {
   std::shared_ptr<scene::Node3D> player_node;
   std::vector<scene::AABB> static_colliders;
   std::map<int, std::shared_ptr<scene::Node3D>> collectibles;
+  std::shared_ptr<scene::StaticBatcher> static_geometry; // walls and floors, merged per chunk
 };
 
 class Level {
 public:
-  LevelResult Load(const std::vector<std::string>& map_data, std::shared_ptr<scene::Window> window, std::shared_ptr<rendering::Lighting> light);
+  LevelResult Load(const std::vector<std::string>& map_data, std::shared_ptr<scene::Window> window);
 };
 
 } // namespace wlw::game
@@ -19,6 +19,7 @@ namespace wlw::platformer {
 
     void Initialize() override {
       engine_->Start(window_);
+      engine_->SetThreadedRendering(true);
       SwitchLevel(0);
     }
 
@@ -75,7 +76,9 @@ namespace wlw::platformer {
       current_light_ = light;
       auto driver = engine_->GetRenderingDriver();
       auto device = engine_->GetRenderDevice();
-      level_data_ = level_loader.Load(map, window_, light, device);
+      window_->ClearLights();
+      window_->AddLight(light);
+      level_data_ = level_loader.Load(map, window_, device);
 
       // --- ADD SKYBOX ---
       std::array<std::string, 6> faces = { "cube.jpg", "cube.jpg", "cube.jpg", "cube.jpg", "cube.jpg", "cube.jpg" };
@@ -1,13 +1,20 @@
 #include "platformer_level.h"
 #include "../game/data_helper.h"
 #include "rendering/material.h"
+#include "core/grid_mesher.h"
+#include <algorithm>
 #include <utils/image_loader.h>
 #include <utils/gltf_loader.h>
 #include <utils/texture_manager.h>
 
 namespace wlw::platformer {
 
-LevelResult Level::Load(const std::vector<std::string>& map_data, std::shared_ptr<scene::Window> window, std::shared_ptr<rendering::Lighting> light, rendering::RenderDevice* device) {
+namespace {
+  // Side of the square tile blocks each layer is meshed in, so off-screen parts of a level are culled.
+  constexpr int kGridChunkCells = 16;
+}
+
+LevelResult Level::Load(const std::vector<std::string>& map_data, std::shared_ptr<scene::Window> window, rendering::RenderDevice* device) {
   LevelResult result;
   result.player_start_pos = {0.0f, 0.0f, 0.0f};
 
@@ -15,40 +22,38 @@ LevelResult Level::Load(const std::vector<std::string>& map_data, std::shared_pt
 
   // Materials
   std::shared_ptr<rendering::Material> wall_material = rendering::Material::Create();
-  wall_material->SetLighting(*light);
+  wall_material->SetLit(true);
   core::Color wall_color = {0.4f, 0.4f, 0.45f, 1.0f};
 
   std::shared_ptr<rendering::Material> bg_material = rendering::Material::Create();
-  bg_material->SetLighting(*light);
+  bg_material->SetLit(true);
   core::Color bg_color = {0.2f, 0.2f, 0.25f, 1.0f};
 
   std::shared_ptr<rendering::Material> far_bg_material = rendering::Material::Create();
-  far_bg_material->SetLighting(*light);
+  far_bg_material->SetLit(true);
   core::Color far_bg_color = {0.1f, 0.1f, 0.15f, 1.0f};
 
   std::shared_ptr<rendering::Material> collectible_material = rendering::Material::Create();
-  collectible_material->SetLighting(*light);
+  collectible_material->SetLit(true);
   core::Color collectible_color = {1.0f, 0.8f, 0.0f, 1.0f};
 
   // Meshes
-  auto wall_mesh = createCubeWithNormals(1.0f, wall_color);
-  auto bg_mesh = createCubeWithNormals(1.0f, bg_color);
-  auto far_bg_mesh = createCubeWithNormals(1.0f, far_bg_color);
   auto collectible_mesh = createGemWithNormals(0.4f, 0.6f);
 
-  auto wall_model = std::make_shared<core::Model<core::Vertex3D>>();
-  wall_model->meshes.push_back(wall_mesh);
-
-  auto bg_model = std::make_shared<core::Model<core::Vertex3D>>();
-  bg_model->meshes.push_back(bg_mesh);
-
-  auto far_bg_model = std::make_shared<core::Model<core::Vertex3D>>();
-  far_bg_model->meshes.push_back(far_bg_mesh);
-
   auto collectible_model = std::make_shared<core::Model<core::Vertex3D>>();
   collectible_model->meshes.push_back(collectible_mesh);
 
   int height = (int)map_data.size();
+  int width = 0;
+  for (const auto& row : map_data) {
+    width = std::max(width, (int)row.size());
+  }
+
+  // Each layer is a one-cell-deep tile grid, meshed as a whole instead of a cube per tile.
+  core::CellGrid wall_grid(width, height, 1);
+  core::CellGrid bg_grid(width, height, 1);
+  core::CellGrid far_bg_grid(width, height, 1);
+
   for (int y = 0; y < height; ++y) {
     int row = height - 1 - y; // Bottom-to-top parsing
     for (int x = 0; x < (int)map_data[row].size(); ++x) {
@@ -56,24 +61,12 @@ LevelResult Level::Load(const std::vector<std::string>& map_data, std::shared_pt
       core::Vector3 pos = {(float)x, (float)y, 0.0f};
 
       if (tile == '#') {
-        auto node = std::make_shared<scene::Node3D>();
-        node->SetModel(wall_model);
-        node->SetMaterial(wall_material);
-        node->SetPosition(pos);
-        window->AddNode(node);
+        wall_grid.Set(x, y, 0, 1);
         result.static_colliders.push_back(scene::AABB::FromPositionAndScale(pos, {1.0f, 1.0f, 1.0f}));
       } else if (tile == 'B') {
-        auto node = std::make_shared<scene::Node3D>();
-        node->SetModel(bg_model);
-        node->SetMaterial(bg_material);
-        node->SetPosition({pos.x, pos.y, -5.0f});
-        window->AddNode(node);
+        bg_grid.Set(x, y, 0, 1);
       } else if (tile == 'F') {
-        auto node = std::make_shared<scene::Node3D>();
-        node->SetModel(far_bg_model);
-        node->SetMaterial(far_bg_material);
-        node->SetPosition({pos.x, pos.y, -15.0f});
-        window->AddNode(node);
+        far_bg_grid.Set(x, y, 0, 1);
       } else if (tile == 'P') {
         auto random_model = utils::GLTFLoader::LoadModel("random_model/scene.gltf", device);
         auto random_model_node = std::make_shared<scene::Node3D>();
@@ -83,7 +76,7 @@ LevelResult Level::Load(const std::vector<std::string>& map_data, std::shared_pt
         random_model_node->SetScale({player_scale, player_scale, player_scale});
 
         std::shared_ptr<rendering::Material> player_mat = rendering::Material::Create();
-        player_mat->SetLighting(*light);
+        player_mat->SetLit(true);
         random_model_node->SetMaterial(player_mat);
 
         result.player_node = random_model_node;
@@ -98,6 +91,24 @@ LevelResult Level::Load(const std::vector<std::string>& map_data, std::shared_pt
       }
     }
   }
+
+  auto add_layer = [&](const core::CellGrid& grid, const core::Color& color, float z, std::shared_ptr<rendering::Material> material) {
+    core::GridMeshSettings settings;
+    settings.colors = {{}, color};
+    for (const auto& chunk : core::BuildGridMeshChunks(grid, settings, kGridChunkCells)) {
+      auto model = std::make_shared<core::Model<core::Vertex3D>>();
+      model->meshes.push_back(chunk.mesh);
+      auto node = std::make_shared<scene::Node3D>();
+      node->SetModel(model);
+      node->SetMaterial(material);
+      node->SetPosition({chunk.box.min[0] - 0.5f, chunk.box.min[1] - 0.5f, z - 0.5f});
+      window->AddNode(node);
+    }
+  };
+  add_layer(wall_grid, wall_color, 0.0f, wall_material);
+  add_layer(bg_grid, bg_color, -5.0f, bg_material);
+  add_layer(far_bg_grid, far_bg_color, -15.0f, far_bg_material);
+
   return result;
 }
 
@@ -19,7 +19,7 @@ struct LevelResult {
 
 class Level {
 public:
-  LevelResult Load(const std::vector<std::string>& map_data, std::shared_ptr<scene::Window> window, std::shared_ptr<rendering::Lighting> light, rendering::RenderDevice* device);
+  LevelResult Load(const std::vector<std::string>& map_data, std::shared_ptr<scene::Window> window, rendering::RenderDevice* device);
 };
 
 
@@ -0,0 +1,159 @@
+#include "grid_mesher.h"
+
+#include <algorithm>
+
+#include "core/logger.h"
+
+namespace wlw::core {
+
+  namespace {
+
+    struct GridMeshBuilder {
+      const GridMeshSettings& settings;
+      float cell_size[3];
+      std::vector<Vertex3D> vertices;
+      std::vector<uint32_t> indices;
+
+      explicit GridMeshBuilder(const GridMeshSettings& mesh_settings)
+        : settings(mesh_settings), cell_size{ mesh_settings.cell_size.x, mesh_settings.cell_size.y, mesh_settings.cell_size.z } {}
+
+      // A w x h cell rectangle on the plane at `plane` along axis d, starting at cell (i, j) on axes u, v,
+      // all in box-relative cells. `face` is the cell type, negated for faces looking down the axis.
+      void AddQuad(int d, int u, int v, int plane, int i, int j, int w, int h, int face) {
+        uint8_t type = (uint8_t)std::abs(face);
+        Color color = type < settings.colors.size() ? settings.colors[type] : Color{ 1.0f, 1.0f, 1.0f, 1.0f };
+
+        float normal[3] = { 0.0f, 0.0f, 0.0f };
+        normal[d] = face > 0 ? 1.0f : -1.0f;
+
+        float corners[4][3];
+        const int offsets[4][2] = { { 0, 0 }, { w, 0 }, { w, h }, { 0, h } };
+        for (int k = 0; k < 4; ++k) {
+          corners[k][d] = plane * cell_size[d];
+          corners[k][u] = (i + offsets[k][0]) * cell_size[u];
+          corners[k][v] = (j + offsets[k][1]) * cell_size[v];
+        }
+
+        uint32_t base = (uint32_t)vertices.size();
+        for (int k = 0; k < 4; ++k) {
+          vertices.push_back({ { corners[k][0], corners[k][1], corners[k][2] }, color, { normal[0], normal[1], normal[2] },
+                               { (float)offsets[k][0], (float)offsets[k][1] } });
+        }
+
+        // Corners run counter-clockwise around +d (u x v == d), so back faces take them in reverse.
+        const uint32_t front[6] = { 0, 1, 2, 2, 3, 0 };
+        const uint32_t back[6] = { 0, 3, 2, 2, 1, 0 };
+        for (uint32_t corner : face > 0 ? front : back) {
+          indices.push_back(base + corner);
+        }
+      }
+    };
+
+  } // namespace
+
+  std::shared_ptr<Mesh<Vertex3D>> BuildGridMesh(const CellGrid& grid, const CellBox& box, const GridMeshSettings& settings) {
+    GridMeshBuilder builder(settings);
+    std::vector<int> mask;
+
+    for (int d = 0; d < 3; ++d) {
+      int u = (d + 1) % 3;
+      int v = (d + 2) % 3;
+      int width = box.max[u] - box.min[u];
+      int height = box.max[v] - box.min[v];
+      if (width <= 0 || height <= 0 || box.max[d] <= box.min[d]) {
+        continue;
+      }
+      mask.assign((size_t)width * height, 0);
+
+      // Plane p separates cells p - 1 and p along d. A face belongs to the solid cell behind it, and only
+      // cells inside the box emit faces.
+      for (int plane = box.min[d]; plane <= box.max[d]; ++plane) {
+        bool back_inside = plane > box.min[d];
+        bool front_inside = plane < box.max[d];
+        for (int j = 0; j < height; ++j) {
+          for (int i = 0; i < width; ++i) {
+            int cell[3];
+            cell[u] = box.min[u] + i;
+            cell[v] = box.min[v] + j;
+            cell[d] = plane - 1;
+            uint8_t back = grid.Get(cell[0], cell[1], cell[2]);
+            cell[d] = plane;
+            uint8_t front = grid.Get(cell[0], cell[1], cell[2]);
+
+            int face = 0;
+            if (back != 0 && front == 0 && back_inside) {
+              face = back;
+            } else if (front != 0 && back == 0 && front_inside) {
+              face = -front;
+            }
+            mask[(size_t)j * width + i] = face;
+          }
+        }
+
+        // Greedy merge: widen each face along u as far as it matches, then grow it along v while the
+        // whole row below matches too.
+        for (int j = 0; j < height; ++j) {
+          for (int i = 0; i < width;) {
+            int face = mask[(size_t)j * width + i];
+            if (face == 0) {
+              ++i;
+              continue;
+            }
+
+            int w = 1;
+            while (i + w < width && mask[(size_t)j * width + i + w] == face) {
+              ++w;
+            }
+            int h = 1;
+            for (; j + h < height; ++h) {
+              const int* row = &mask[(size_t)(j + h) * width + i];
+              if (std::any_of(row, row + w, [face](int other) { return other != face; })) {
+                break;
+              }
+            }
+
+            for (int l = 0; l < h; ++l) {
+              std::fill_n(&mask[(size_t)(j + l) * width + i], w, 0);
+            }
+            builder.AddQuad(d, u, v, plane - box.min[d], i, j, w, h, face);
+            i += w;
+          }
+        }
+      }
+    }
+
+    auto mesh = std::make_shared<Mesh<Vertex3D>>();
+    mesh->name = "grid";
+    mesh->SetVertices(std::move(builder.vertices));
+    mesh->SetIndices(std::move(builder.indices));
+    return mesh;
+  }
+
+  std::vector<GridMeshChunk> BuildGridMeshChunks(const CellGrid& grid, const GridMeshSettings& settings, int chunk_cells) {
+    std::vector<GridMeshChunk> chunks;
+    if (FAIL_IF(chunk_cells <= 0, "grid mesh chunks need a positive size")) {
+      return chunks;
+    }
+
+    for (int z = 0; z < grid.size_z; z += chunk_cells) {
+      for (int y = 0; y < grid.size_y; y += chunk_cells) {
+        for (int x = 0; x < grid.size_x; x += chunk_cells) {
+          CellBox box;
+          box.min[0] = x;
+          box.min[1] = y;
+          box.min[2] = z;
+          box.max[0] = std::min(x + chunk_cells, grid.size_x);
+          box.max[1] = std::min(y + chunk_cells, grid.size_y);
+          box.max[2] = std::min(z + chunk_cells, grid.size_z);
+
+          auto mesh = BuildGridMesh(grid, box, settings);
+          if (mesh->GetIndexCount() > 0) {
+            chunks.push_back({ box, mesh });
+          }
+        }
+      }
+    }
+    return chunks;
+  }
+
+} // namespace wlw::core
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "core/color.h"
+#include "core/mesh.h"
+#include "core/vector3.h"
+#include "core/vertex_3d.h"
+
+namespace wlw::core {
+
+  // A dense grid of box-shaped cells. 0 is empty; any other value is an opaque cell type, and cells of the
+  // same type share a color and may be merged into one face.
+  struct CellGrid {
+    int size_x = 0;
+    int size_y = 0;
+    int size_z = 0;
+    std::vector<uint8_t> cells;
+
+    CellGrid() = default;
+    CellGrid(int x, int y, int z) : size_x(x), size_y(y), size_z(z), cells((size_t)x * y * z, 0) {}
+
+    // Out-of-range cells read as empty, so the grid's outer faces are kept.
+    uint8_t Get(int x, int y, int z) const {
+      if (x < 0 || y < 0 || z < 0 || x >= size_x || y >= size_y || z >= size_z) {
+        return 0;
+      }
+      return cells[((size_t)z * size_y + y) * size_x + x];
+    }
+
+    void Set(int x, int y, int z, uint8_t type) {
+      cells[((size_t)z * size_y + y) * size_x + x] = type;
+    }
+  };
+
+  // A half-open box of cells, [min, max) on each axis.
+  struct CellBox {
+    int min[3] = { 0, 0, 0 };
+    int max[3] = { 0, 0, 0 };
+  };
+
+  struct GridMeshSettings {
+    Vector3 cell_size = { 1.0f, 1.0f, 1.0f };
+    // Vertex color of each cell type, indexed by type; types past the end are white.
+    std::vector<Color> colors;
+  };
+
+  // Meshes the cells in `box` as a single surface: faces between two solid cells are dropped (neighbours
+  // outside `box` count too, so adjacent boxes do not leave walls between them) and coplanar faces of the
+  // same type are greedily merged into rectangles. Positions are relative to the corner of `box`, UVs are
+  // in cells so textures repeat once per cell. Merged faces meet at T-junctions.
+  std::shared_ptr<Mesh<Vertex3D>> BuildGridMesh(const CellGrid& grid, const CellBox& box, const GridMeshSettings& settings);
+
+  struct GridMeshChunk {
+    CellBox box;
+    std::shared_ptr<Mesh<Vertex3D>> mesh;
+  };
+
+  // BuildGridMesh over the whole grid in boxes of at most `chunk_cells` per side, so each piece keeps
+  // tight bounds for culling. Boxes without any visible face are left out.
+  std::vector<GridMeshChunk> BuildGridMeshChunks(const CellGrid& grid, const GridMeshSettings& settings, int chunk_cells);
+
+} // namespace wlw::core
@@ -3,28 +3,65 @@
 #include <type_traits>
 #include <memory>
 #include <vector>
+#include <span>
 #include <array>
 #include <algorithm>
+#include <atomic>
 #include <glm/glm.hpp>
 
 #include "core/vertex_2d.h"
 #include "core/vertex_3d.h"
+#include "core/meshlet.h"
 #include "rendering/material.h"
-#include "rendering/vertex_buffer.h"
-#include "rendering/index_buffer.h"
+#include "rendering/geometry_pool.h"
 #include "core/collision.h"
+#include "core/logger.h"
 
 namespace wlw::core {
 
+// What a mesh keeps in RAM once its geometry is on the GPU. Released data is dropped on the render thread
+// right after the upload, so other threads must not read the vertices of a mesh whose policy releases them.
+enum class MeshResidency : uint8_t {
+	Keep,               // everything (default): the mesh can be edited and re-uploaded
+	ReleaseAfterUpload, // only bounds, counts, meshlets and LODs stay
+	KeepPositions,      // positions and indices stay, for collision and picking
+};
+
+struct MeshMemoryStats {
+	size_t cpu_bytes = 0;      // vertex, index, position and meshlet storage of every live mesh
+	size_t released_bytes = 0; // freed by residency policies since startup
+};
+
+namespace mesh_memory {
+	inline std::atomic<size_t> cpu_bytes = 0;
+	inline std::atomic<size_t> released_bytes = 0;
+} // namespace mesh_memory
+
+inline MeshMemoryStats GetMeshMemoryStats() {
+	return { mesh_memory::cpu_bytes.load(), mesh_memory::released_bytes.load() };
+}
+
 template <typename T>
 concept OnlyVerticesTypes =
 	std::is_same_v<T, core::Vertex2D> ||
 	std::is_same_v<T, core::Vertex3D>;
 
+// Meshes are built and edited on the update thread until ExtractSceneSnapshot first hands one to the render
+// thread (Publish). From then on the render thread reads its data for uploads and owns its GPU geometry and
+// residency release, so the mesh is immutable: every edit below fails and leaves it unchanged. To change a
+// drawn mesh, build a new one and swap it into the node's model.
 template <OnlyVerticesTypes T>
 class Mesh {
 public:
-	virtual ~Mesh() = default;
+	using Position = decltype(T::position);
+
+	Mesh() = default;
+	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
+
+	virtual ~Mesh() {
+		mesh_memory::cpu_bytes -= accounted_bytes_;
+	}
 
 	const std::vector<T>& GetVertices() const {
 		return vertices_;
@@ -34,30 +71,109 @@ public:
 		return indices_;
 	}
 
-	void SetVertices(const std::vector<T>& vertices) {
-		vertices_ = vertices;
-		vertex_buffer_ = nullptr;
-		index_buffer_ = nullptr;
+	// Survive a ReleaseAfterUpload / KeepPositions release, unlike the vectors above.
+	size_t GetVertexCount() const { return vertex_count_; }
+	size_t GetIndexCount() const { return index_count_; }
 
-        if (vertices_.empty()) {
-            local_aabb_ = { {0,0,0}, {0,0,0} };
-            return;
-        }
+	// Copies `vertices`; pass an rvalue vector to hand the buffer over instead.
+	void SetVertices(std::span<const T> vertices) {
+		if (!CanEdit()) {
+			return;
+		}
+		if (vertices.data() != vertices_.data()) {
+			vertices_.assign(vertices.begin(), vertices.end());
+		}
+		OnVerticesChanged();
+	}
 
-        glm::vec3 minB(vertices_[0].position.x, vertices_[0].position.y, vertices_[0].position.z);
-        glm::vec3 maxB = minB;
-        for (const auto& v : vertices_) {
-            minB = glm::min(minB, glm::vec3(v.position.x, v.position.y, v.position.z));
-            maxB = glm::max(maxB, glm::vec3(v.position.x, v.position.y, v.position.z));
-        }
-        local_aabb_ = { {minB.x, minB.y, minB.z}, {maxB.x, maxB.y, maxB.z} };
+	void SetVertices(std::vector<T>&& vertices) {
+		if (!CanEdit()) {
+			return;
+		}
+		vertices_ = std::move(vertices);
+		OnVerticesChanged();
+	}
+
+	// Edits the vertices in place through `edit(std::vector<T>&)`, then refreshes the bounds and drops
+	// everything derived from the old data (GPU geometry, meshlets, LODs).
+	template <typename Edit>
+	void EditVertices(Edit&& edit) {
+		if (!CanEdit()) {
+			return;
+		}
+		edit(vertices_);
+		OnVerticesChanged();
 	}
 
     const scene::AABB& GetLocalAABB() const { return local_aabb_; }
 
-	void SetIndices(const std::vector<uint32_t>& indices) {
-		indices_ = indices;
-		index_buffer_ = nullptr;
+	void SetIndices(std::span<const uint32_t> indices) {
+		if (!CanEdit()) {
+			return;
+		}
+		if (indices.data() != indices_.data()) {
+			indices_.assign(indices.begin(), indices.end());
+		}
+		OnDataChanged();
+	}
+
+	void SetIndices(std::vector<uint32_t>&& indices) {
+		if (!CanEdit()) {
+			return;
+		}
+		indices_ = std::move(indices);
+		OnDataChanged();
+	}
+
+	template <typename Edit>
+	void EditIndices(Edit&& edit) {
+		if (!CanEdit()) {
+			return;
+		}
+		edit(indices_);
+		OnDataChanged();
+	}
+
+	// For passes that rewrite both at once (welding, reordering): `edit(std::vector<T>&, std::vector<uint32_t>&)`.
+	template <typename Edit>
+	void EditGeometry(Edit&& edit) {
+		if (!CanEdit()) {
+			return;
+		}
+		edit(vertices_, indices_);
+		OnVerticesChanged();
+	}
+
+	// Contiguous index runs culled individually by the scene snapshot. Built at import for large meshes;
+	// dropped whenever the vertices or indices change, since they would no longer match.
+	void SetMeshlets(std::vector<Meshlet> meshlets) {
+		if (!CanEdit()) {
+			return;
+		}
+		meshlets_ = std::move(meshlets);
+		UpdateMemoryAccounting();
+	}
+
+	const std::vector<Meshlet>& GetMeshlets() const {
+		return meshlets_;
+	}
+
+	// A coarser version of this mesh and how far (mesh space distance) it deviates from it.
+	struct Lod {
+		std::shared_ptr<Mesh> mesh;
+		float error = 0.0f;
+	};
+
+	// Ordered fine to coarse. Generated at import; dropped with the geometry they were simplified from.
+	void SetLods(std::vector<Lod> lods) {
+		if (!CanEdit()) {
+			return;
+		}
+		lods_ = std::move(lods);
+	}
+
+	const std::vector<Lod>& GetLods() const {
+		return lods_;
 	}
 
 	void SetMaterial(const std::shared_ptr<rendering::Material>& material) {
@@ -68,32 +184,150 @@ public:
 		return material_;
 	}
 
-	void SetVertexBuffer(std::unique_ptr<WVertexBuffer> vertex_buffer) {
-		vertex_buffer_ = std::move(vertex_buffer);
+	// The (offset, count) ranges this mesh occupies in the render device's geometry pool.
+	void SetGeometry(std::unique_ptr<rendering::GeometryAllocation> geometry) {
+		geometry_ = std::move(geometry);
 	}
 
-	const WVertexBuffer* GetVertexBuffer() const {
-		return vertex_buffer_.get();
+	void SetResidency(MeshResidency residency) {
+		if (!CanEdit()) {
+			return;
+		}
+		residency_ = residency;
+		if (geometry_) {
+			OnGeometryUploaded();
+		}
 	}
 
-	void SetIndexBuffer(std::unique_ptr<WIndexBuffer> index_buffer) {
-		index_buffer_ = std::move(index_buffer);
+	MeshResidency GetResidency() const {
+		return residency_;
 	}
 
-	const WIndexBuffer* GetIndexBuffer() const {
-		return index_buffer_.get();
+	// Called by the upload stage once the pool owns a copy of the data; applies the residency policy.
+	void OnGeometryUploaded() {
+		if (residency_ == MeshResidency::Keep || cpu_data_released_) {
+			return;
+		}
+
+		size_t before = accounted_bytes_;
+		if (residency_ == MeshResidency::KeepPositions) {
+			positions_.reserve(vertices_.size());
+			for (const auto& vertex : vertices_) {
+				positions_.push_back(vertex.position);
+			}
+		}
+		else {
+			std::vector<uint32_t>().swap(indices_);
+		}
+		std::vector<T>().swap(vertices_);
+		cpu_data_released_ = true;
+
+		UpdateMemoryAccounting();
+		mesh_memory::released_bytes += before - accounted_bytes_;
+	}
+
+	// True once a residency policy dropped the vertices; the mesh can no longer be uploaded again.
+	bool IsCpuDataReleased() const {
+		return cpu_data_released_;
+	}
+
+	// Valid while the vertices are resident, or after a KeepPositions release.
+	const Position& GetPosition(uint32_t index) const {
+		return cpu_data_released_ ? positions_[index] : vertices_[index].position;
+	}
+
+	const rendering::GeometryAllocation* GetGeometry() const {
+		return geometry_.get();
+	}
+
+	// 3D meshes upload as core::PackedVertex3D (20 bytes instead of 48) unless this is turned off, e.g. for
+	// meshes so large that 16 bits over their bounds is too coarse.
+	void SetPackedVertices(bool packed) {
+		if (!CanEdit()) {
+			return;
+		}
+		if (FAIL_IF(cpu_data_released_ && geometry_ && packed != packed_vertices_, "mesh data was released after upload, keeping its current vertex format")) {
+			return;
+		}
+		packed_vertices_ = packed;
+		geometry_ = nullptr;
+	}
+
+	bool HasPackedVertices() const {
+		return packed_vertices_ && std::is_same_v<T, core::Vertex3D>;
+	}
+
+	// Called by ExtractSceneSnapshot (update thread) for every mesh it hands to the render thread.
+	void Publish() {
+		published_.store(true, std::memory_order_relaxed);
+	}
+
+	bool IsPublished() const {
+		return published_.load(std::memory_order_relaxed);
 	}
 
 	std::string name = "";
 
 protected:
+	bool CanEdit() const {
+		return !FAIL_IF(IsPublished(), "mesh '" + name + "' is already drawn by the render thread and can no longer be edited, build a new mesh instead");
+	}
+
+	// GPU geometry, meshlets and LODs are all built from the current vertices and indices.
+	void OnDataChanged() {
+		geometry_ = nullptr;
+		meshlets_.clear();
+		lods_.clear();
+		if (cpu_data_released_) {
+			std::vector<Position>().swap(positions_);
+			cpu_data_released_ = false;
+		}
+		vertex_count_ = vertices_.size();
+		index_count_ = indices_.size();
+		UpdateMemoryAccounting();
+	}
+
+	void OnVerticesChanged() {
+		OnDataChanged();
+
+        if (vertices_.empty()) {
+            local_aabb_ = { {0,0,0}, {0,0,0} };
+            return;
+        }
+
+        glm::vec3 minB(vertices_[0].position.x, vertices_[0].position.y, vertices_[0].position.z);
+        glm::vec3 maxB = minB;
+        for (const auto& v : vertices_) {
+            minB = glm::min(minB, glm::vec3(v.position.x, v.position.y, v.position.z));
+            maxB = glm::max(maxB, glm::vec3(v.position.x, v.position.y, v.position.z));
+        }
+        local_aabb_ = { {minB.x, minB.y, minB.z}, {maxB.x, maxB.y, maxB.z} };
+	}
+
+	void UpdateMemoryAccounting() {
+		size_t bytes = vertices_.capacity() * sizeof(T) + indices_.capacity() * sizeof(uint32_t) +
+			positions_.capacity() * sizeof(Position) + meshlets_.capacity() * sizeof(Meshlet);
+		mesh_memory::cpu_bytes += bytes;
+		mesh_memory::cpu_bytes -= accounted_bytes_;
+		accounted_bytes_ = bytes;
+	}
+
 	std::vector<T> vertices_;
 	std::vector<uint32_t> indices_;
+	std::vector<Meshlet> meshlets_;
+	std::vector<Lod> lods_;
+	std::vector<Position> positions_; // KeepPositions only, once released
+	size_t vertex_count_ = 0;
+	size_t index_count_ = 0;
+	size_t accounted_bytes_ = 0;
+	MeshResidency residency_ = MeshResidency::Keep;
+	bool cpu_data_released_ = false;
+	std::atomic<bool> published_ = false;
 
-	std::unique_ptr<WVertexBuffer> vertex_buffer_ = nullptr;
-	std::unique_ptr<WIndexBuffer> index_buffer_ = nullptr;
+	std::unique_ptr<rendering::GeometryAllocation> geometry_ = nullptr;
 
 	std::shared_ptr<rendering::Material> material_ = nullptr;
+	bool packed_vertices_ = true;
 
     scene::AABB local_aabb_ = { {0,0,0}, {0,0,0} };
 };
@@ -0,0 +1,364 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+namespace wlw::core {
+
+  namespace {
+
+    bool IndicesInRange(const std::vector<uint32_t>& indices, uint32_t vertex_count) {
+      return std::all_of(indices.begin(), indices.end(), [vertex_count](uint32_t index) { return index < vertex_count; });
+    }
+
+    glm::vec3 ToVec3(const Vector3& v) {
+      return glm::vec3(v.x, v.y, v.z);
+    }
+
+    constexpr size_t kVertexFloats = sizeof(Vertex3D) / sizeof(float);
+    static_assert(sizeof(Vertex3D) == kVertexFloats * sizeof(float), "Vertex3D must be plain floats for welding");
+
+    void ToFloats(const Vertex3D& vertex, float out[kVertexFloats]) {
+      std::memcpy(out, &vertex, sizeof(Vertex3D));
+    }
+
+    uint64_t HashCombine(uint64_t hash, uint64_t value) {
+      return (hash ^ value) * 0x100000001B3ull;
+    }
+
+    struct ExactVertexHash {
+      size_t operator()(const Vertex3D& vertex) const {
+        float values[kVertexFloats];
+        ToFloats(vertex, values);
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (float value : values) {
+          value += 0.0f; // -0 and +0 compare equal, so they must hash equal
+          uint32_t bits;
+          std::memcpy(&bits, &value, sizeof(bits));
+          hash = HashCombine(hash, bits);
+        }
+        return (size_t)hash;
+      }
+    };
+
+    struct ExactVertexEqual {
+      bool operator()(const Vertex3D& a, const Vertex3D& b) const {
+        float va[kVertexFloats], vb[kVertexFloats];
+        ToFloats(a, va);
+        ToFloats(b, vb);
+        return std::equal(va, va + kVertexFloats, vb);
+      }
+    };
+
+    bool WithinEpsilon(const Vertex3D& a, const Vertex3D& b, float epsilon) {
+      float va[kVertexFloats], vb[kVertexFloats];
+      ToFloats(a, va);
+      ToFloats(b, vb);
+      for (size_t i = 0; i < kVertexFloats; ++i) {
+        if (std::abs(va[i] - vb[i]) > epsilon) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    // Remaps every vertex to the output slot of its first match; `find` returns that slot or ~0u.
+    template <typename Find>
+    size_t Compact(std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices, Find&& find) {
+      std::vector<uint32_t> remap(vertices.size());
+      std::vector<Vertex3D> unique;
+      unique.reserve(vertices.size());
+      for (size_t i = 0; i < vertices.size(); ++i) {
+        uint32_t slot = find(vertices[i], (uint32_t)unique.size());
+        if (slot == (uint32_t)unique.size()) {
+          unique.push_back(vertices[i]);
+        }
+        remap[i] = slot;
+      }
+      for (uint32_t& index : indices) {
+        index = remap[index];
+      }
+      size_t removed = vertices.size() - unique.size();
+      vertices = std::move(unique);
+      return removed;
+    }
+
+  } // namespace
+
+  size_t WeldVertices(std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices, float epsilon) {
+    if (vertices.size() < 2 || !IndicesInRange(indices, (uint32_t)vertices.size())) {
+      return 0;
+    }
+
+    if (epsilon <= 0.0f) {
+      std::unordered_map<Vertex3D, uint32_t, ExactVertexHash, ExactVertexEqual> slots;
+      slots.reserve(vertices.size());
+      return Compact(vertices, indices, [&](const Vertex3D& vertex, uint32_t next) {
+        return slots.emplace(vertex, next).first->second;
+      });
+    }
+
+    // Hash on the position's epsilon-sized grid cell. A match within epsilon is at most one cell away on
+    // each axis, so the 27 surrounding cells are searched; a candidate merges if its position and every
+    // attribute are within epsilon. Only the exact path above hashes bit patterns.
+    auto cell_of = [epsilon](float value) { return (int64_t)std::floor(value / epsilon); };
+    auto cell_key = [](int64_t x, int64_t y, int64_t z) {
+      return HashCombine(HashCombine(HashCombine(0xCBF29CE484222325ull, (uint64_t)x), (uint64_t)y), (uint64_t)z);
+    };
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+    std::vector<Vertex3D> kept;
+    kept.reserve(vertices.size());
+    return Compact(vertices, indices, [&](const Vertex3D& vertex, uint32_t next) {
+      int64_t cx = cell_of(vertex.position.x), cy = cell_of(vertex.position.y), cz = cell_of(vertex.position.z);
+      for (int64_t dx = -1; dx <= 1; ++dx) {
+        for (int64_t dy = -1; dy <= 1; ++dy) {
+          for (int64_t dz = -1; dz <= 1; ++dz) {
+            auto it = cells.find(cell_key(cx + dx, cy + dy, cz + dz));
+            if (it == cells.end()) {
+              continue;
+            }
+            for (uint32_t slot : it->second) {
+              if (WithinEpsilon(kept[slot], vertex, epsilon)) {
+                return slot;
+              }
+            }
+          }
+        }
+      }
+      cells[cell_key(cx, cy, cz)].push_back(next);
+      kept.push_back(vertex);
+      return next;
+    });
+  }
+
+  size_t WeldMesh(Mesh<Vertex3D>& mesh, float epsilon) {
+    size_t removed = 0;
+    mesh.EditGeometry([&](std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices) {
+      removed = WeldVertices(vertices, indices, epsilon);
+    });
+    return removed;
+  }
+
+  float ComputeACMR(const std::vector<uint32_t>& indices, uint32_t vertex_count, uint32_t cache_size) {
+    size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0 || !IndicesInRange(indices, vertex_count)) {
+      return 0.0f;
+    }
+
+    // FIFO: a vertex is a hit while fewer than cache_size misses happened since it was loaded.
+    std::vector<uint32_t> loaded_at(vertex_count, 0);
+    uint32_t misses = 0;
+    for (uint32_t index : indices) {
+      if (loaded_at[index] == 0 || misses - loaded_at[index] >= cache_size) {
+        misses++;
+        loaded_at[index] = misses;
+      }
+    }
+    return (float)misses / (float)triangle_count;
+  }
+
+  std::vector<uint32_t> OptimizeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertex_count,
+                                            std::vector<uint32_t>* clusters, uint32_t cache_size) {
+    uint32_t triangle_count = (uint32_t)(indices.size() / 3);
+    if (clusters) {
+      clusters->assign(1, 0);
+    }
+    if (triangle_count == 0 || !IndicesInRange(indices, vertex_count)) {
+      return indices;
+    }
+
+    // Vertex -> triangles adjacency, as offsets into one flat list.
+    std::vector<uint32_t> live(vertex_count, 0);
+    for (uint32_t index : indices) {
+      live[index]++;
+    }
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    for (uint32_t v = 0; v < vertex_count; ++v) {
+      offsets[v + 1] = offsets[v] + live[v];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (uint32_t t = 0; t < triangle_count; ++t) {
+      for (int k = 0; k < 3; ++k) {
+        adjacency[fill[indices[t * 3 + k]]++] = t;
+      }
+    }
+
+    std::vector<uint32_t> cache_time(vertex_count, 0);
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<uint32_t> dead_end;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    uint32_t time = cache_size + 1;
+    uint32_t cursor = 1;
+    int64_t fanning = 0;
+
+    while (fanning >= 0) {
+      uint32_t vertex = (uint32_t)fanning;
+      candidates.clear();
+
+      for (uint32_t a = offsets[vertex]; a < offsets[vertex + 1]; ++a) {
+        uint32_t t = adjacency[a];
+        if (emitted[t]) {
+          continue;
+        }
+        emitted[t] = true;
+        for (int k = 0; k < 3; ++k) {
+          uint32_t v = indices[t * 3 + k];
+          output.push_back(v);
+          dead_end.push_back(v);
+          candidates.push_back(v);
+          live[v]--;
+          if (time - cache_time[v] > cache_size) {
+            cache_time[v] = time++;
+          }
+        }
+      }
+
+      // Next fanning vertex: the candidate that will still be in the cache after its remaining
+      // triangles are emitted, preferring the oldest such entry.
+      int64_t best = -1;
+      int64_t best_priority = -1;
+      for (uint32_t v : candidates) {
+        if (live[v] == 0) {
+          continue;
+        }
+        int64_t priority = 0;
+        if (time - cache_time[v] + 2 * live[v] <= cache_size) {
+          priority = time - cache_time[v];
+        }
+        if (priority > best_priority) {
+          best_priority = priority;
+          best = v;
+        }
+      }
+
+      if (best == -1) {
+        // Dead end: the cache is effectively flushed, which makes this a cluster boundary.
+        while (!dead_end.empty() && best == -1) {
+          uint32_t v = dead_end.back();
+          dead_end.pop_back();
+          if (live[v] > 0) {
+            best = v;
+          }
+        }
+        while (best == -1 && cursor < vertex_count) {
+          if (live[cursor] > 0) {
+            best = cursor;
+          }
+          cursor++;
+        }
+        if (best != -1 && clusters && output.size() / 3 < triangle_count) {
+          clusters->push_back((uint32_t)(output.size() / 3));
+        }
+      }
+      fanning = best;
+    }
+
+    return output;
+  }
+
+  std::vector<uint32_t> OptimizeOverdraw(const std::vector<uint32_t>& indices, const std::vector<Vertex3D>& vertices,
+                                         const std::vector<uint32_t>& clusters, float threshold) {
+    uint32_t triangle_count = (uint32_t)(indices.size() / 3);
+    if (clusters.size() < 2 || triangle_count == 0 || !IndicesInRange(indices, (uint32_t)vertices.size())) {
+      return indices;
+    }
+
+    glm::vec3 mesh_center(0.0f);
+    float mesh_area = 0.0f;
+    struct Cluster {
+      uint32_t begin, end;
+      float sort_key;
+    };
+    std::vector<Cluster> sorted;
+    std::vector<glm::vec3> centers;
+    std::vector<glm::vec3> normals;
+
+    for (size_t c = 0; c < clusters.size(); ++c) {
+      uint32_t begin = clusters[c];
+      uint32_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangle_count;
+      glm::vec3 center(0.0f), normal(0.0f);
+      float area = 0.0f;
+      for (uint32_t t = begin; t < end; ++t) {
+        glm::vec3 p0 = ToVec3(vertices[indices[t * 3]].position);
+        glm::vec3 p1 = ToVec3(vertices[indices[t * 3 + 1]].position);
+        glm::vec3 p2 = ToVec3(vertices[indices[t * 3 + 2]].position);
+        glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+        float triangle_area = glm::length(cross) * 0.5f;
+        center += (p0 + p1 + p2) * (triangle_area / 3.0f);
+        normal += cross;
+        area += triangle_area;
+      }
+      mesh_center += center;
+      mesh_area += area;
+      centers.push_back(area > 0.0f ? center / area : center);
+      normals.push_back(glm::length(normal) > 0.0f ? glm::normalize(normal) : normal);
+      sorted.push_back({ begin, end, 0.0f });
+    }
+    if (mesh_area > 0.0f) {
+      mesh_center = mesh_center / mesh_area;
+    }
+
+    for (size_t c = 0; c < sorted.size(); ++c) {
+      sorted[c].sort_key = glm::dot(centers[c] - mesh_center, normals[c]);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) { return a.sort_key > b.sort_key; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (const auto& cluster : sorted) {
+      output.insert(output.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+    }
+
+    float acmr_in = ComputeACMR(indices, (uint32_t)vertices.size());
+    float acmr_out = ComputeACMR(output, (uint32_t)vertices.size());
+    return acmr_out <= acmr_in * threshold ? output : indices;
+  }
+
+  std::vector<Vertex3D> OptimizeVertexFetch(const std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices) {
+    if (!IndicesInRange(indices, (uint32_t)vertices.size())) {
+      return vertices;
+    }
+
+    static constexpr uint32_t kUnused = ~0u;
+    std::vector<uint32_t> remap(vertices.size(), kUnused);
+    std::vector<Vertex3D> output;
+    output.reserve(vertices.size());
+    for (uint32_t& index : indices) {
+      if (remap[index] == kUnused) {
+        remap[index] = (uint32_t)output.size();
+        output.push_back(vertices[index]);
+      }
+      index = remap[index];
+    }
+    return output;
+  }
+
+  MeshOptimizationStats OptimizeMesh(Mesh<Vertex3D>& mesh) {
+    MeshOptimizationStats stats;
+    uint32_t vertex_count = (uint32_t)mesh.GetVertices().size();
+    stats.acmr_before = ComputeACMR(mesh.GetIndices(), vertex_count);
+    if (mesh.GetIndices().size() < 3 || !IndicesInRange(mesh.GetIndices(), vertex_count)) {
+      stats.acmr_after = stats.acmr_before;
+      return stats;
+    }
+
+    mesh.EditGeometry([&](std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices) {
+      std::vector<uint32_t> clusters;
+      indices = OptimizeVertexCache(indices, vertex_count, &clusters);
+      indices = OptimizeOverdraw(indices, vertices, clusters);
+      vertices = OptimizeVertexFetch(vertices, indices);
+
+      stats.cluster_count = (uint32_t)clusters.size();
+      stats.acmr_after = ComputeACMR(indices, (uint32_t)vertices.size());
+    });
+    return stats;
+  }
+
+} // namespace wlw::core
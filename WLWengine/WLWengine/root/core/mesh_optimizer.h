@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "core/mesh.h"
+#include "core/vertex_3d.h"
+
+namespace wlw::core {
+
+  // Size of the FIFO post-transform cache the orderings are tuned for and ACMR is measured against.
+  constexpr uint32_t kVertexCacheSize = 16;
+
+  struct MeshOptimizationStats {
+    float acmr_before = 0.0f; // average cache misses per triangle: 3.0 worst, ~0.5 ideal
+    float acmr_after = 0.0f;
+    uint32_t cluster_count = 0;
+  };
+
+  // Collapses duplicate vertices and rewrites `indices` to the survivors; returns how many were removed.
+  // With epsilon == 0 only identical vertices merge (lossless). With epsilon > 0 a vertex merges into
+  // an earlier one whose every attribute (position, color, normal, UV) is within epsilon of it.
+  size_t WeldVertices(std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices, float epsilon = 0.0f);
+
+  // WeldVertices applied to a mesh's own buffers.
+  size_t WeldMesh(Mesh<Vertex3D>& mesh, float epsilon = 0.0f);
+
+  // Vertex shader invocations per triangle for a FIFO cache of `cache_size` entries.
+  float ComputeACMR(const std::vector<uint32_t>& indices, uint32_t vertex_count, uint32_t cache_size = kVertexCacheSize);
+
+  // Tipsify (Sander et al. 2007): reorders triangles so vertices are reused while still in the cache.
+  // `clusters`, if given, receives the triangle offset of every cache-flush point, which the overdraw
+  // pass uses as the boundaries it may move runs of triangles across.
+  std::vector<uint32_t> OptimizeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertex_count,
+                                            std::vector<uint32_t>* clusters = nullptr, uint32_t cache_size = kVertexCacheSize);
+
+  // Orders the clusters so those facing away from the mesh center (likely in front from most view
+  // directions) draw first. Keeps the input order if that would raise ACMR by more than `threshold`.
+  std::vector<uint32_t> OptimizeOverdraw(const std::vector<uint32_t>& indices, const std::vector<Vertex3D>& vertices,
+                                         const std::vector<uint32_t>& clusters, float threshold = 1.05f);
+
+  // Renumbers vertices in first-use order so fetches walk the vertex buffer forward; unreferenced
+  // vertices are dropped. Rewrites `indices` in place.
+  std::vector<Vertex3D> OptimizeVertexFetch(const std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices);
+
+  // All three passes, in order. Meant to run once at import time, not per frame.
+  MeshOptimizationStats OptimizeMesh(Mesh<Vertex3D>& mesh);
+
+} // namespace wlw::core
@@ -0,0 +1,415 @@
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <glm/glm.hpp>
+
+#include "core/mesh_optimizer.h"
+
+namespace wlw::core {
+
+  namespace {
+
+    // Open boundary planes are weighted well above surface planes so borders stay put.
+    constexpr double kBorderWeight = 10.0;
+    // An attribute difference of 1.0 costs as much as moving this fraction of the mesh extent.
+    constexpr float kAttributeWeight = 0.01f;
+    // Collapses whose triangles would tilt by more than this (cosine) are rejected as flips.
+    constexpr float kMinFlipCosine = 0.25f;
+
+    enum class VertexKind : uint8_t {
+      Manifold, // interior, one attribute set
+      Border,   // on an open boundary
+      Seam,     // interior, shares its position with exactly one other vertex (UV or normal seam)
+      Locked,   // anything else: never moves
+    };
+
+    struct Quadric {
+      // Symmetric 4x4 plane quadric, plus the accumulated weight so Eval returns a mean squared distance.
+      double a2 = 0, b2 = 0, c2 = 0, ab = 0, ac = 0, bc = 0, ad = 0, bd = 0, cd = 0, d2 = 0;
+      double weight = 0;
+
+      void AddPlane(const glm::vec3& normal, float distance, double w) {
+        double a = normal.x, b = normal.y, c = normal.z, d = distance;
+        a2 += w * a * a; b2 += w * b * b; c2 += w * c * c;
+        ab += w * a * b; ac += w * a * c; bc += w * b * c;
+        ad += w * a * d; bd += w * b * d; cd += w * c * d;
+        d2 += w * d * d;
+        weight += w;
+      }
+
+      void Add(const Quadric& q) {
+        a2 += q.a2; b2 += q.b2; c2 += q.c2; ab += q.ab; ac += q.ac; bc += q.bc;
+        ad += q.ad; bd += q.bd; cd += q.cd; d2 += q.d2; weight += q.weight;
+      }
+
+      float Eval(const glm::vec3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double error = a2 * x * x + b2 * y * y + c2 * z * z + 2.0 * (ab * x * y + ac * x * z + bc * y * z)
+                     + 2.0 * (ad * x + bd * y + cd * z) + d2;
+        return weight > 0.0 ? (float)std::max(error / weight, 0.0) : 0.0f;
+      }
+    };
+
+    glm::vec3 ToVec3(const Vector3& v) {
+      return glm::vec3(v.x, v.y, v.z);
+    }
+
+    uint64_t EdgeKey(uint32_t a, uint32_t b) {
+      return ((uint64_t)a << 32) | b;
+    }
+
+    float AttributeDistance(const Vertex3D& a, const Vertex3D& b) {
+      glm::vec3 dn = ToVec3(a.normal) - ToVec3(b.normal);
+      float du = a.texCoords.x - b.texCoords.x, dv = a.texCoords.y - b.texCoords.y;
+      float dr = a.color.r - b.color.r, dg = a.color.g - b.color.g, db = a.color.b - b.color.b, da = a.color.a - b.color.a;
+      return glm::dot(dn, dn) + du * du + dv * dv + dr * dr + dg * dg + db * db + da * da;
+    }
+
+    struct PositionHash {
+      size_t operator()(const Vector3& p) const {
+        uint32_t bits[3];
+        float values[3] = { p.x + 0.0f, p.y + 0.0f, p.z + 0.0f };
+        std::memcpy(bits, values, sizeof(bits));
+        return (size_t)((bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u));
+      }
+    };
+
+    struct PositionEqual {
+      bool operator()(const Vector3& a, const Vector3& b) const {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+      }
+    };
+
+    struct Collapse {
+      uint32_t from;
+      uint32_t to;
+      float cost;
+    };
+
+  } // namespace
+
+  std::vector<uint32_t> SimplifyMesh(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& indices,
+                                     size_t target_index_count, float target_error, float* result_error) {
+    std::vector<uint32_t> result = indices;
+    float max_error = 0.0f;
+    if (result_error) {
+      *result_error = 0.0f;
+    }
+    uint32_t vertex_count = (uint32_t)vertices.size();
+    if (indices.size() % 3 != 0 || indices.size() <= target_index_count ||
+        std::any_of(indices.begin(), indices.end(), [vertex_count](uint32_t i) { return i >= vertex_count; })) {
+      return result;
+    }
+
+    // Vertices sharing a position are one point of the surface: `position_of` maps to the first of them,
+    // `wedge` cycles through the others.
+    std::vector<uint32_t> position_of(vertex_count);
+    std::vector<uint32_t> wedge(vertex_count);
+    {
+      std::unordered_map<Vector3, uint32_t, PositionHash, PositionEqual> first;
+      first.reserve(vertex_count);
+      for (uint32_t v = 0; v < vertex_count; ++v) {
+        auto [it, inserted] = first.emplace(vertices[v].position, v);
+        position_of[v] = it->second;
+        wedge[v] = v;
+        if (!inserted) {
+          wedge[v] = wedge[it->second];
+          wedge[it->second] = v;
+        }
+      }
+    }
+
+    // A position edge is open when no triangle walks it the other way.
+    std::unordered_set<uint64_t> position_edges;
+    position_edges.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); i += 3) {
+      for (int k = 0; k < 3; ++k) {
+        position_edges.insert(EdgeKey(position_of[indices[i + k]], position_of[indices[i + (k + 1) % 3]]));
+      }
+    }
+    auto is_open = [&position_edges](uint32_t pa, uint32_t pb) {
+      return position_edges.count(EdgeKey(pa, pb)) != position_edges.count(EdgeKey(pb, pa));
+    };
+
+    std::vector<Quadric> quadrics(vertex_count);
+    std::vector<bool> on_border(vertex_count, false);
+    glm::vec3 min_bound = ToVec3(vertices[indices[0]].position), max_bound = min_bound;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+      uint32_t p[3] = { position_of[indices[i]], position_of[indices[i + 1]], position_of[indices[i + 2]] };
+      glm::vec3 pos[3] = { ToVec3(vertices[p[0]].position), ToVec3(vertices[p[1]].position), ToVec3(vertices[p[2]].position) };
+      for (const auto& q : pos) {
+        min_bound = glm::min(min_bound, q);
+        max_bound = glm::max(max_bound, q);
+      }
+
+      glm::vec3 normal = glm::cross(pos[1] - pos[0], pos[2] - pos[0]);
+      float length = glm::length(normal);
+      if (length <= 0.0f) {
+        continue;
+      }
+      normal = normal / length;
+      double area = length * 0.5;
+      for (int k = 0; k < 3; ++k) {
+        quadrics[p[k]].AddPlane(normal, -glm::dot(normal, pos[0]), area);
+      }
+
+      for (int k = 0; k < 3; ++k) {
+        uint32_t a = p[k], b = p[(k + 1) % 3];
+        if (!is_open(a, b)) {
+          continue;
+        }
+        on_border[a] = on_border[b] = true;
+        // A plane through the open edge, perpendicular to the triangle.
+        glm::vec3 edge = pos[(k + 1) % 3] - pos[k];
+        glm::vec3 side = glm::cross(edge, normal);
+        float side_length = glm::length(side);
+        if (side_length > 0.0f) {
+          side = side / side_length;
+          double weight = kBorderWeight * glm::dot(edge, edge);
+          quadrics[a].AddPlane(side, -glm::dot(side, pos[k]), weight);
+          quadrics[b].AddPlane(side, -glm::dot(side, pos[k]), weight);
+        }
+      }
+    }
+
+    std::vector<VertexKind> kind(vertex_count);
+    for (uint32_t v = 0; v < vertex_count; ++v) {
+      uint32_t wedges = 1;
+      for (uint32_t w = wedge[v]; w != v; w = wedge[w]) {
+        wedges++;
+      }
+      bool border = on_border[position_of[v]];
+      if (wedges == 1) {
+        kind[v] = border ? VertexKind::Border : VertexKind::Manifold;
+      }
+      else {
+        kind[v] = wedges == 2 && !border ? VertexKind::Seam : VertexKind::Locked;
+      }
+    }
+
+    glm::vec3 extent = max_bound - min_bound;
+    float attribute_scale = kAttributeWeight * std::max(extent.x, std::max(extent.y, extent.z));
+    float attribute_weight = attribute_scale * attribute_scale;
+    float error_limit = target_error * target_error;
+
+    std::unordered_set<uint64_t> corner_edges;
+    std::vector<uint32_t> adjacency_offsets(vertex_count + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> candidates;
+    std::vector<uint32_t> collapse_to(vertex_count);
+    std::vector<bool> locked(vertex_count);
+
+    while (result.size() > target_index_count) {
+      size_t triangle_count = result.size() / 3;
+
+      corner_edges.clear();
+      for (size_t i = 0; i < result.size(); i += 3) {
+        for (int k = 0; k < 3; ++k) {
+          corner_edges.insert(EdgeKey(result[i + k], result[i + (k + 1) % 3]));
+        }
+      }
+      auto has_corner_edge = [&corner_edges](uint32_t a, uint32_t b) {
+        return corner_edges.count(EdgeKey(a, b)) || corner_edges.count(EdgeKey(b, a));
+      };
+
+      // Triangles around each position.
+      std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0);
+      for (uint32_t index : result) {
+        adjacency_offsets[position_of[index] + 1]++;
+      }
+      for (uint32_t v = 0; v < vertex_count; ++v) {
+        adjacency_offsets[v + 1] += adjacency_offsets[v];
+      }
+      adjacency.resize(result.size());
+      {
+        std::vector<uint32_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+        for (size_t i = 0; i < result.size(); ++i) {
+          adjacency[fill[position_of[result[i]]]++] = (uint32_t)(i / 3);
+        }
+      }
+
+      // The twin a seam vertex moves with: the other wedge of `from`, onto the matching wedge of `to`.
+      auto seam_twin = [&](uint32_t from, uint32_t to, uint32_t& twin_from, uint32_t& twin_to) {
+        twin_from = wedge[from];
+        twin_to = wedge[to];
+        // Along the seam the edge is open in corner space: the triangle across it uses the twins.
+        bool forward = corner_edges.count(EdgeKey(from, to)) != 0;
+        bool backward = corner_edges.count(EdgeKey(to, from)) != 0;
+        return kind[to] == VertexKind::Seam && forward != backward && has_corner_edge(twin_from, twin_to);
+      };
+
+      auto allowed = [&](uint32_t from, uint32_t to) {
+        switch (kind[from]) {
+        case VertexKind::Manifold:
+          return true;
+        case VertexKind::Border:
+          return is_open(position_of[from], position_of[to]);
+        case VertexKind::Seam: {
+          uint32_t twin_from, twin_to;
+          return seam_twin(from, to, twin_from, twin_to);
+        }
+        default:
+          return false;
+        }
+      };
+
+      auto cost = [&](uint32_t from, uint32_t to) {
+        float error = quadrics[position_of[from]].Eval(ToVec3(vertices[to].position));
+        error += attribute_weight * AttributeDistance(vertices[from], vertices[to]);
+        if (kind[from] == VertexKind::Seam) {
+          error += attribute_weight * AttributeDistance(vertices[wedge[from]], vertices[wedge[to]]);
+        }
+        return error;
+      };
+
+      candidates.clear();
+      for (size_t i = 0; i < result.size(); i += 3) {
+        for (int k = 0; k < 3; ++k) {
+          uint32_t a = result[i + k], b = result[i + (k + 1) % 3];
+          if (position_of[a] == position_of[b]) {
+            continue;
+          }
+          // Each interior edge is seen from both triangles; the cheaper direction wins either way.
+          if (allowed(a, b)) {
+            candidates.push_back({ a, b, cost(a, b) });
+          }
+          if (allowed(b, a)) {
+            candidates.push_back({ b, a, cost(b, a) });
+          }
+        }
+      }
+      std::sort(candidates.begin(), candidates.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+      // Moving `from`'s position onto `to` must not turn any surviving triangle around it over.
+      auto flips = [&](uint32_t from, uint32_t to) {
+        uint32_t p_from = position_of[from], p_to = position_of[to];
+        glm::vec3 target = ToVec3(vertices[p_to].position);
+        for (uint32_t a = adjacency_offsets[p_from]; a < adjacency_offsets[p_from + 1]; ++a) {
+          const uint32_t* triangle = &result[adjacency[a] * 3];
+          glm::vec3 before[3], after[3];
+          bool collapses = false;
+          for (int k = 0; k < 3; ++k) {
+            uint32_t p = position_of[triangle[k]];
+            collapses |= p == p_to;
+            before[k] = ToVec3(vertices[p].position);
+            after[k] = p == p_from ? target : before[k];
+          }
+          if (collapses) {
+            continue;
+          }
+          glm::vec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+          glm::vec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+          float l0 = glm::length(n0), l1 = glm::length(n1);
+          if (l0 > 0.0f && (l1 <= 0.0f || glm::dot(n0, n1) < kMinFlipCosine * l0 * l1)) {
+            return true;
+          }
+        }
+        return false;
+      };
+
+      // Each pass collapses a set of edges whose one-rings do not overlap, so every decision above still holds.
+      for (uint32_t v = 0; v < vertex_count; ++v) {
+        collapse_to[v] = v;
+      }
+      std::fill(locked.begin(), locked.end(), false);
+      size_t goal = triangle_count - target_index_count / 3;
+      size_t removed = 0;
+      for (const Collapse& collapse : candidates) {
+        if (collapse.cost > error_limit || removed >= goal) {
+          break;
+        }
+        uint32_t p_from = position_of[collapse.from], p_to = position_of[collapse.to];
+        if (locked[p_from] || locked[p_to] || flips(collapse.from, collapse.to)) {
+          continue;
+        }
+
+        collapse_to[collapse.from] = collapse.to;
+        if (kind[collapse.from] == VertexKind::Seam) {
+          uint32_t twin_from, twin_to;
+          seam_twin(collapse.from, collapse.to, twin_from, twin_to);
+          collapse_to[twin_from] = twin_to;
+        }
+        quadrics[p_to].Add(quadrics[p_from]);
+        max_error = std::max(max_error, collapse.cost);
+
+        for (uint32_t a = adjacency_offsets[p_from]; a < adjacency_offsets[p_from + 1]; ++a) {
+          const uint32_t* triangle = &result[adjacency[a] * 3];
+          bool collapses = false;
+          for (int k = 0; k < 3; ++k) {
+            locked[position_of[triangle[k]]] = true;
+            collapses |= position_of[triangle[k]] == p_to;
+          }
+          removed += collapses ? 1 : 0;
+        }
+        locked[p_from] = locked[p_to] = true;
+      }
+      if (removed == 0) {
+        break;
+      }
+
+      size_t write = 0;
+      for (size_t i = 0; i < result.size(); i += 3) {
+        uint32_t a = collapse_to[result[i]], b = collapse_to[result[i + 1]], c = collapse_to[result[i + 2]];
+        if (position_of[a] == position_of[b] || position_of[b] == position_of[c] || position_of[a] == position_of[c]) {
+          continue;
+        }
+        result[write++] = a;
+        result[write++] = b;
+        result[write++] = c;
+      }
+      result.resize(write);
+    }
+
+    if (result_error) {
+      *result_error = std::sqrt(max_error);
+    }
+    return result;
+  }
+
+  size_t GenerateLods(Mesh<Vertex3D>& mesh) {
+    using MeshLod = Mesh<Vertex3D>::Lod;
+    const auto& vertices = mesh.GetVertices();
+    const auto& indices = mesh.GetIndices();
+    std::vector<MeshLod> lods;
+    if (indices.size() / 3 < kLodMinMeshTriangles || vertices.empty()) {
+      mesh.SetLods(std::move(lods));
+      return 0;
+    }
+
+    const scene::AABB& bounds = mesh.GetLocalAABB();
+    float extent = std::max(bounds.max.x - bounds.min.x, std::max(bounds.max.y - bounds.min.y, bounds.max.z - bounds.min.z));
+    float max_error = kLodMaxRelativeError * extent;
+
+    size_t previous_count = indices.size();
+    for (float ratio : kLodTriangleRatios) {
+      size_t target = (size_t)(indices.size() / 3 * ratio) * 3;
+      float error = 0.0f;
+      std::vector<uint32_t> lod_indices = SimplifyMesh(vertices, indices, target, max_error, &error);
+      if (lod_indices.empty() || lod_indices.size() * 5 > previous_count * 4) {
+        break;
+      }
+      previous_count = lod_indices.size();
+
+      lod_indices = OptimizeVertexCache(lod_indices, (uint32_t)vertices.size());
+      std::vector<Vertex3D> lod_vertices = OptimizeVertexFetch(vertices, lod_indices);
+
+      auto lod_mesh = std::make_shared<Mesh<Vertex3D>>();
+      lod_mesh->name = mesh.name + "_lod" + std::to_string(lods.size() + 1);
+      lod_mesh->SetVertices(std::move(lod_vertices));
+      lod_mesh->SetIndices(std::move(lod_indices));
+      lod_mesh->SetMaterial(mesh.GetMaterial());
+      lod_mesh->SetPackedVertices(mesh.HasPackedVertices());
+      lods.push_back({ lod_mesh, error });
+    }
+
+    size_t count = lods.size();
+    mesh.SetLods(std::move(lods));
+    return count;
+  }
+
+} // namespace wlw::core
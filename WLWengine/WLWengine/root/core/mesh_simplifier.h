@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "core/mesh.h"
+#include "core/vertex_3d.h"
+
+namespace wlw::core {
+
+  // Triangle budgets of the generated LODs, relative to the full mesh.
+  constexpr float kLodTriangleRatios[] = { 0.5f, 0.2f, 0.08f };
+  // Meshes smaller than this are cheap enough to always draw in full.
+  constexpr uint32_t kLodMinMeshTriangles = 512;
+  // No LOD may deviate from the full mesh by more than this fraction of its largest extent.
+  constexpr float kLodMaxRelativeError = 0.05f;
+
+  // Quadric error edge-collapse simplification (Garland & Heckbert) over the existing vertices: only
+  // `indices` are rewritten, every surviving corner keeps its original vertex.
+  //  - Attribute-aware: collapses are also charged for the normal / UV / color difference they smear, and
+  //    vertices on a UV or normal seam only collapse along the seam, together with their twin.
+  //  - Border-preserving: open-boundary vertices only slide along the boundary, held to it by extra planes.
+  // Stops at `target_index_count` or before any collapse would exceed `target_error` (mesh space distance).
+  // `result_error`, if given, receives the largest error actually introduced.
+  std::vector<uint32_t> SimplifyMesh(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& indices,
+                                     size_t target_index_count, float target_error, float* result_error = nullptr);
+
+  // Fills `mesh`'s LOD chain from kLodTriangleRatios. Each LOD is a separate, cache- and fetch-optimized mesh
+  // sharing `mesh`'s material; LODs that would not save at least a fifth of the previous level are dropped.
+  // Returns the number of LODs generated.
+  size_t GenerateLods(Mesh<Vertex3D>& mesh);
+
+} // namespace wlw::core
@@ -0,0 +1,116 @@
+#include "meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace wlw::core {
+
+  namespace {
+
+    glm::vec3 ToVec3(const Vector3& v) {
+      return glm::vec3(v.x, v.y, v.z);
+    }
+
+    void ComputeBounds(Meshlet& meshlet, const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& indices) {
+      uint32_t end = meshlet.first_index + meshlet.index_count;
+
+      glm::vec3 min_bound = ToVec3(vertices[indices[meshlet.first_index]].position);
+      glm::vec3 max_bound = min_bound;
+      for (uint32_t i = meshlet.first_index; i < end; ++i) {
+        glm::vec3 p = ToVec3(vertices[indices[i]].position);
+        min_bound = glm::min(min_bound, p);
+        max_bound = glm::max(max_bound, p);
+      }
+      meshlet.center = (min_bound + max_bound) * 0.5f;
+      float radius_squared = 0.0f;
+      for (uint32_t i = meshlet.first_index; i < end; ++i) {
+        glm::vec3 offset = ToVec3(vertices[indices[i]].position) - meshlet.center;
+        radius_squared = std::max(radius_squared, glm::dot(offset, offset));
+      }
+      meshlet.radius = std::sqrt(radius_squared);
+
+      std::vector<glm::vec3> normals;
+      normals.reserve(meshlet.index_count / 3);
+      glm::vec3 axis(0.0f);
+      for (uint32_t i = meshlet.first_index; i < end; i += 3) {
+        glm::vec3 p0 = ToVec3(vertices[indices[i]].position);
+        glm::vec3 p1 = ToVec3(vertices[indices[i + 1]].position);
+        glm::vec3 p2 = ToVec3(vertices[indices[i + 2]].position);
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float length = glm::length(normal);
+        if (length > 0.0f) {
+          normals.push_back(normal / length);
+          axis += normals.back();
+        }
+      }
+
+      float axis_length = glm::length(axis);
+      if (normals.empty() || axis_length <= 0.0f) {
+        return; // degenerate: keep the never-culled cone
+      }
+      meshlet.cone_axis = axis / axis_length;
+
+      float min_dot = 1.0f;
+      for (const auto& normal : normals) {
+        min_dot = std::min(min_dot, glm::dot(normal, meshlet.cone_axis));
+      }
+      // A cone wider than a hemisphere has a front-facing triangle from every direction.
+      meshlet.cone_cutoff = min_dot <= 0.0f ? 1.0f : std::sqrt(1.0f - min_dot * min_dot);
+    }
+
+  } // namespace
+
+  std::vector<Meshlet> BuildMeshlets(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& indices,
+                                     uint32_t max_vertices, uint32_t max_triangles) {
+    std::vector<Meshlet> meshlets;
+    uint32_t triangle_count = (uint32_t)(indices.size() / 3);
+    if (triangle_count == 0 || max_vertices < 3 || max_triangles == 0) {
+      return meshlets;
+    }
+    for (uint32_t index : indices) {
+      if (index >= vertices.size()) {
+        return meshlets;
+      }
+    }
+
+    // Stamped with meshlet number + 1, so starting a meshlet resets the set without clearing it.
+    std::vector<uint32_t> vertex_stamp(vertices.size(), 0);
+    uint32_t stamp = 1;
+    uint32_t unique_vertices = 0;
+    Meshlet current;
+
+    for (uint32_t t = 0; t < triangle_count; ++t) {
+      const uint32_t* triangle = &indices[t * 3];
+      uint32_t new_vertices = 0;
+      for (int k = 0; k < 3; ++k) {
+        bool repeated = (k > 0 && triangle[k] == triangle[0]) || (k > 1 && triangle[k] == triangle[1]);
+        if (vertex_stamp[triangle[k]] != stamp && !repeated) {
+          new_vertices++;
+        }
+      }
+
+      if (current.index_count > 0 &&
+          (unique_vertices + new_vertices > max_vertices || current.index_count / 3 + 1 > max_triangles)) {
+        ComputeBounds(current, vertices, indices);
+        meshlets.push_back(current);
+        current = Meshlet();
+        current.first_index = t * 3;
+        stamp++;
+        unique_vertices = 0;
+      }
+
+      for (int k = 0; k < 3; ++k) {
+        if (vertex_stamp[triangle[k]] != stamp) {
+          vertex_stamp[triangle[k]] = stamp;
+          unique_vertices++;
+        }
+      }
+      current.index_count += 3;
+    }
+
+    ComputeBounds(current, vertices, indices);
+    meshlets.push_back(current);
+    return meshlets;
+  }
+
+} // namespace wlw::core
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "core/vertex_3d.h"
+
+namespace wlw::core {
+
+  // Meshlet size limits; 64 / 124 keeps a meshlet's vertices and triangles within one small batch.
+  constexpr uint32_t kMeshletMaxVertices = 64;
+  constexpr uint32_t kMeshletMaxTriangles = 124;
+  // Below this, splitting costs more draw ranges than culling saves; the whole mesh is culled as one.
+  constexpr uint32_t kMeshletMinMeshTriangles = 1024;
+
+  // A contiguous run of a mesh's index buffer with bounds for per-cluster culling, all in mesh space.
+  struct Meshlet {
+    uint32_t first_index = 0;
+    uint32_t index_count = 0;
+
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+
+    // Every triangle normal lies within the cone around `cone_axis`; cone_cutoff is the sine of its
+    // half-angle, 1.0 for a meshlet too curved to ever be back-facing as a whole.
+    glm::vec3 cone_axis = glm::vec3(0.0f, 0.0f, 1.0f);
+    float cone_cutoff = 1.0f;
+  };
+
+  // Splits `indices` into meshlets in their current triangle order, so an earlier cache optimization
+  // survives and no indices need rewriting.
+  std::vector<Meshlet> BuildMeshlets(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& indices,
+                                     uint32_t max_vertices = kMeshletMaxVertices, uint32_t max_triangles = kMeshletMaxTriangles);
+
+  // True if no triangle of the meshlet can face `camera_position`. Everything in the same space.
+  inline bool IsMeshletBackFacing(const glm::vec3& center, float radius, const glm::vec3& cone_axis, float cone_cutoff,
+                                  const glm::vec3& camera_position) {
+    glm::vec3 to_center = center - camera_position;
+    return glm::dot(to_center, cone_axis) >= cone_cutoff * glm::length(to_center) + radius;
+  }
+
+} // namespace wlw::core
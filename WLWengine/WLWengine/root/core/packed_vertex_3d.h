@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "vertex_3d.h"
+
+namespace wlw::core {
+
+	// GPU-only form of Vertex3D, 20 bytes instead of 48:
+	//  - position: int16 per axis over the mesh bounds, position = offset + value * scale (w is padding)
+	//  - normal: octahedral, int16 x2 in [-32767, 32767]
+	//  - texCoords: half floats
+	//  - color: RGBA8
+	// Positions and normals are fed to the shader as plain integers (not GL-normalized) and rescaled there,
+	// so the result does not depend on which signed-normalized conversion rule the driver follows.
+	struct PackedVertex3D {
+		int16_t position[4];
+		int16_t normal[2];
+		uint16_t texCoords[2];
+		uint8_t color[4];
+	};
+	static_assert(sizeof(PackedVertex3D) == 20, "PackedVertex3D must match the packed vertex attribute layout");
+
+	struct PackedVertices3D {
+		std::vector<PackedVertex3D> vertices;
+		Vector3 position_offset = { 0.0f, 0.0f, 0.0f };
+		Vector3 position_scale = { 1.0f, 1.0f, 1.0f };
+	};
+
+	inline uint16_t FloatToHalf(float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		uint32_t sign = (bits >> 16) & 0x8000u;
+		int32_t exponent = (int32_t)((bits >> 23) & 0xFFu) - 127 + 15;
+		uint32_t mantissa = bits & 0x7FFFFFu;
+
+		if (exponent >= 31) {
+			// Overflow and infinities saturate to infinity; NaN stays NaN.
+			bool nan = ((bits >> 23) & 0xFFu) == 0xFFu && mantissa != 0;
+			return (uint16_t)(sign | 0x7C00u | (nan ? 0x200u : 0u));
+		}
+		if (exponent <= 0) {
+			if (exponent < -10) {
+				return (uint16_t)sign;
+			}
+			// Denormal: shift the implicit leading one in, round to nearest.
+			mantissa |= 0x800000u;
+			uint32_t shift = (uint32_t)(14 - exponent);
+			uint32_t half = mantissa >> shift;
+			if ((mantissa >> (shift - 1)) & 1u) {
+				half++;
+			}
+			return (uint16_t)(sign | half);
+		}
+
+		uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+		// Round to nearest; a carry into the exponent is the correct result.
+		if (mantissa & 0x1000u) {
+			half++;
+		}
+		return (uint16_t)half;
+	}
+
+	inline int16_t ToSnorm16(float value) {
+		return (int16_t)std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f);
+	}
+
+	// Octahedral mapping: project onto the |x|+|y|+|z| = 1 octahedron, fold the lower half over the upper.
+	inline void EncodeOctahedralNormal(const Vector3& normal, int16_t out[2]) {
+		float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+		if (length <= 0.0f) {
+			out[0] = 0;
+			out[1] = 0;
+			return;
+		}
+		float x = normal.x / length;
+		float y = normal.y / length;
+		if (normal.z < 0.0f) {
+			float folded_x = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			float folded_y = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+			x = folded_x;
+			y = folded_y;
+		}
+		out[0] = ToSnorm16(x);
+		out[1] = ToSnorm16(y);
+	}
+
+	// Inverse of EncodeOctahedralNormal; mirrors DecodeNormal in the packed 3D vertex shader.
+	inline Vector3 DecodeOctahedralNormal(const int16_t encoded[2]) {
+		float x = encoded[0] / 32767.0f;
+		float y = encoded[1] / 32767.0f;
+		float z = 1.0f - std::abs(x) - std::abs(y);
+		float t = std::max(-z, 0.0f);
+		x += x >= 0.0f ? -t : t;
+		y += y >= 0.0f ? -t : t;
+		float length = std::sqrt(x * x + y * y + z * z);
+		return { x / length, y / length, z / length };
+	}
+
+	inline uint8_t ToUnorm8(float value) {
+		return (uint8_t)std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f);
+	}
+
+	// Quantizes positions to the bounds of `vertices`. Vertices on the bounds map exactly to +-32767, so
+	// meshes that meet along their bounds (voxel blocks, tiles) stay watertight.
+	inline PackedVertices3D PackVertices(const std::vector<Vertex3D>& vertices) {
+		PackedVertices3D packed;
+		packed.vertices.resize(vertices.size());
+		if (vertices.empty()) {
+			return packed;
+		}
+
+		Vector3 min_bound = vertices[0].position;
+		Vector3 max_bound = vertices[0].position;
+		for (const auto& vertex : vertices) {
+			min_bound = { std::min(min_bound.x, vertex.position.x), std::min(min_bound.y, vertex.position.y), std::min(min_bound.z, vertex.position.z) };
+			max_bound = { std::max(max_bound.x, vertex.position.x), std::max(max_bound.y, vertex.position.y), std::max(max_bound.z, vertex.position.z) };
+		}
+
+		const float center[3] = { (min_bound.x + max_bound.x) * 0.5f, (min_bound.y + max_bound.y) * 0.5f, (min_bound.z + max_bound.z) * 0.5f };
+		const float extent[3] = { (max_bound.x - min_bound.x) * 0.5f, (max_bound.y - min_bound.y) * 0.5f, (max_bound.z - min_bound.z) * 0.5f };
+		packed.position_offset = { center[0], center[1], center[2] };
+		packed.position_scale = { extent[0] / 32767.0f, extent[1] / 32767.0f, extent[2] / 32767.0f };
+
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			const Vertex3D& vertex = vertices[i];
+			PackedVertex3D& out = packed.vertices[i];
+
+			const float position[3] = { vertex.position.x, vertex.position.y, vertex.position.z };
+			for (int axis = 0; axis < 3; ++axis) {
+				// A flat axis has a single value, the center.
+				out.position[axis] = extent[axis] > 0.0f ? ToSnorm16((position[axis] - center[axis]) / extent[axis]) : 0;
+			}
+			out.position[3] = 0;
+
+			EncodeOctahedralNormal(vertex.normal, out.normal);
+			out.texCoords[0] = FloatToHalf(vertex.texCoords.x);
+			out.texCoords[1] = FloatToHalf(vertex.texCoords.y);
+			out.color[0] = ToUnorm8(vertex.color.r);
+			out.color[1] = ToUnorm8(vertex.color.g);
+			out.color[2] = ToUnorm8(vertex.color.b);
+			out.color[3] = ToUnorm8(vertex.color.a);
+		}
+		return packed;
+	}
+
+} // namespace wlw::core
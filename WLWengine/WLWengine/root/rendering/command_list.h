@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "rendering/geometry_pool.h"
+#include "rendering/texture.h"
+
+namespace wlw::rendering {
+
+  enum class CommandType : uint8_t {
+    BindProgram,
+    BindGeometry,
+    BindTexture,
+    SetUniformInt,
+    SetUniformFloat,
+    SetUniformVec3,
+    SetUniformMat3,
+    SetUniformMat4,
+    DrawIndexed,
+    DrawIndexedRanges,
+    SetCullMode
+  };
+
+  // Face culling for the following draws. BackMirrored culls back faces of clockwise-front (mirrored) geometry.
+  enum class CullMode : uint8_t {
+    None,
+    Back,
+    BackMirrored
+  };
+
+  // Every packet is a header followed by one of the POD payloads below, padded to 8 bytes.
+  struct CommandHeader {
+    CommandType type;
+    uint8_t reserved = 0;
+    uint16_t size = 0; // header + payload + padding
+  };
+
+  struct CmdBindProgram { uint32_t program; };
+  struct CmdBindGeometry { GeometryRange range; };
+  struct CmdBindTexture { const WTexture* texture; uint32_t slot; };
+  struct CmdUniformInt { int32_t location; int32_t value; };
+  struct CmdUniformFloat { int32_t location; float value; };
+  struct CmdUniformVec3 { int32_t location; float value[3]; };
+  struct CmdUniformMat3 { int32_t location; float value[9]; };
+  struct CmdUniformMat4 { int32_t location; float value[16]; };
+  struct CmdDrawIndexed { GeometryRange range; };
+  struct CmdDrawIndexedRanges { GeometryRange range; const IndexRange* ranges; uint32_t range_count; };
+  struct CmdSetCullMode { CullMode mode; };
+
+  // Backend-agnostic recording of binds, uniform writes and draws into a compact byte stream.
+  // Recording touches no graphics API, so lists can be filled on any thread and replayed later,
+  // in order, on the thread that owns the context. Referenced textures and index ranges must outlive the replay.
+  class CommandList {
+  public:
+    void Reset() {
+      data_.clear();
+      command_count_ = 0;
+    }
+
+    void BindProgram(uint32_t program) {
+      Push(CommandType::BindProgram, CmdBindProgram{ program });
+    }
+
+    void BindGeometry(const GeometryRange& range) {
+      Push(CommandType::BindGeometry, CmdBindGeometry{ range });
+    }
+
+    void BindTexture(uint32_t slot, const WTexture* texture) {
+      Push(CommandType::BindTexture, CmdBindTexture{ texture, slot });
+    }
+
+    void SetUniform(int32_t location, int32_t value) {
+      Push(CommandType::SetUniformInt, CmdUniformInt{ location, value });
+    }
+
+    void SetUniform(int32_t location, float value) {
+      Push(CommandType::SetUniformFloat, CmdUniformFloat{ location, value });
+    }
+
+    void SetUniform(int32_t location, const glm::vec3& value) {
+      CmdUniformVec3 cmd{ location, {} };
+      std::memcpy(cmd.value, glm::value_ptr(value), sizeof(cmd.value));
+      Push(CommandType::SetUniformVec3, cmd);
+    }
+
+    void SetUniform(int32_t location, const glm::mat3& value) {
+      CmdUniformMat3 cmd{ location, {} };
+      std::memcpy(cmd.value, glm::value_ptr(value), sizeof(cmd.value));
+      Push(CommandType::SetUniformMat3, cmd);
+    }
+
+    void SetUniform(int32_t location, const glm::mat4& value) {
+      CmdUniformMat4 cmd{ location, {} };
+      std::memcpy(cmd.value, glm::value_ptr(value), sizeof(cmd.value));
+      Push(CommandType::SetUniformMat4, cmd);
+    }
+
+    void DrawIndexed(const GeometryRange& range) {
+      Push(CommandType::DrawIndexed, CmdDrawIndexed{ range });
+    }
+
+    // Draws only `ranges` of `range`'s indices, as one multi-draw.
+    void DrawIndexedRanges(const GeometryRange& range, const IndexRange* ranges, uint32_t range_count) {
+      Push(CommandType::DrawIndexedRanges, CmdDrawIndexedRanges{ range, ranges, range_count });
+    }
+
+    void SetCullMode(CullMode mode) {
+      Push(CommandType::SetCullMode, CmdSetCullMode{ mode });
+    }
+
+    size_t GetCommandCount() const { return command_count_; }
+    size_t GetByteSize() const { return data_.size(); }
+    bool IsEmpty() const { return data_.empty(); }
+
+    // Walks the stream in recording order. Payloads are copied out, so the stream needs no alignment.
+    class Reader {
+    public:
+      explicit Reader(const CommandList& list) : data_(list.data_) {}
+
+      bool Next(CommandHeader& header) {
+        if (offset_ >= data_.size()) {
+          return false;
+        }
+        std::memcpy(&header, data_.data() + offset_, sizeof(CommandHeader));
+        payload_ = offset_ + sizeof(CommandHeader);
+        offset_ += header.size;
+        return true;
+      }
+
+      template <typename T>
+      T Read() const {
+        T payload;
+        std::memcpy(&payload, data_.data() + payload_, sizeof(T));
+        return payload;
+      }
+
+    private:
+      const std::vector<uint8_t>& data_;
+      size_t offset_ = 0;
+      size_t payload_ = 0;
+    };
+
+  private:
+    template <typename T>
+    void Push(CommandType type, const T& payload) {
+      static_assert(std::is_trivially_copyable_v<T>, "command payloads must be POD");
+      constexpr size_t kPacketSize = (sizeof(CommandHeader) + sizeof(T) + 7) & ~size_t(7);
+
+      CommandHeader header{ type, 0, (uint16_t)kPacketSize };
+      size_t offset = data_.size();
+      data_.resize(offset + kPacketSize);
+      std::memcpy(data_.data() + offset, &header, sizeof(CommandHeader));
+      std::memcpy(data_.data() + offset + sizeof(CommandHeader), &payload, sizeof(T));
+      command_count_++;
+    }
+
+    std::vector<uint8_t> data_;
+    size_t command_count_ = 0;
+  };
+
+} // namespace wlw::rendering
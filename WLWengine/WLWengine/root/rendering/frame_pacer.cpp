@@ -0,0 +1,79 @@
+#include "frame_pacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace wlw::rendering {
+
+  void FramePacer::SetMode(PresentMode mode, float target_fps) {
+    mode_ = mode;
+    target_fps_ = std::max(1.0f, target_fps);
+    scheduled_ = false;
+  }
+
+  void FramePacer::WaitForNextFrame() {
+    if (mode_ != PresentMode::Capped) {
+      return;
+    }
+
+    auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / target_fps_));
+    auto now = Clock::now();
+    if (!scheduled_ || now > next_frame_ + period) {
+      // First frame, or more than a frame late: restart the schedule instead of rushing to catch up.
+      next_frame_ = now + period;
+      scheduled_ = true;
+      return;
+    }
+
+    // Sleeps overshoot by up to the OS timer slice, so the last stretch is spun.
+    static constexpr auto kSpinTime = std::chrono::milliseconds(2);
+    if (now < next_frame_ - kSpinTime) {
+      std::this_thread::sleep_until(next_frame_ - kSpinTime);
+    }
+    while (Clock::now() < next_frame_) {
+      std::this_thread::yield();
+    }
+    next_frame_ += period;
+  }
+
+  void FramePacer::OnPresent() {
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (presented_) {
+      intervals_[next_interval_] = std::chrono::duration<float, std::milli>(now - last_present_).count();
+      next_interval_ = (next_interval_ + 1) % kHistory;
+      interval_count_ = std::min(interval_count_ + 1, kHistory);
+    }
+    last_present_ = now;
+    presented_ = true;
+  }
+
+  FrameTimingStats FramePacer::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FrameTimingStats stats;
+    if (interval_count_ == 0) {
+      return stats;
+    }
+
+    float sum = 0.0f;
+    stats.min_milliseconds = intervals_[0];
+    stats.max_milliseconds = intervals_[0];
+    for (size_t i = 0; i < interval_count_; ++i) {
+      sum += intervals_[i];
+      stats.min_milliseconds = std::min(stats.min_milliseconds, intervals_[i]);
+      stats.max_milliseconds = std::max(stats.max_milliseconds, intervals_[i]);
+    }
+    stats.average_milliseconds = sum / interval_count_;
+
+    float variance = 0.0f;
+    for (size_t i = 0; i < interval_count_; ++i) {
+      float delta = intervals_[i] - stats.average_milliseconds;
+      variance += delta * delta;
+    }
+    stats.jitter_milliseconds = std::sqrt(variance / interval_count_);
+    stats.samples = (uint32_t)interval_count_;
+    return stats;
+  }
+
+} // namespace wlw::rendering
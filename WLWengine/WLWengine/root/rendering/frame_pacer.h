@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace wlw::rendering {
+
+  enum class PresentMode : uint8_t {
+    VSync,    // every swap waits for the vertical blank
+    Adaptive, // waits for the blank, but a late frame tears instead of waiting a whole extra refresh
+    Capped,   // no vsync; the update loop is held to a target frame rate
+    Uncapped, // no vsync, no cap; for benchmarks
+  };
+
+  inline const char* GetPresentModeName(PresentMode mode) {
+    switch (mode) {
+    case PresentMode::VSync: return "vsync";
+    case PresentMode::Adaptive: return "adaptive vsync";
+    case PresentMode::Capped: return "capped";
+    case PresentMode::Uncapped: return "uncapped";
+    default: return "unknown";
+    }
+  }
+
+  // Swap interval the windows should use in `mode`; see Window::SetSwapInterval.
+  inline int GetSwapInterval(PresentMode mode) {
+    switch (mode) {
+    case PresentMode::VSync: return 1;
+    case PresentMode::Adaptive: return -1;
+    default: return 0;
+    }
+  }
+
+  // Present-to-present intervals over the last FramePacer::kHistory frames.
+  struct FrameTimingStats {
+    float average_milliseconds = 0.0f;
+    float jitter_milliseconds = 0.0f; // standard deviation of the interval
+    float min_milliseconds = 0.0f;
+    float max_milliseconds = 0.0f;
+    uint32_t samples = 0;
+  };
+
+  // Holds the update loop to a frame rate in Capped mode and measures how evenly frames reach the screen
+  // in every mode. Vsync pacing itself is left to the swap interval.
+  class FramePacer {
+  public:
+    static constexpr size_t kHistory = 120;
+
+    // Update thread.
+    void SetMode(PresentMode mode, float target_fps = 60.0f);
+    PresentMode GetMode() const { return mode_; }
+    float GetTargetFps() const { return target_fps_; }
+
+    // Update thread, once per iteration. In Capped mode sleeps, then spins, until the next frame slot.
+    void WaitForNextFrame();
+
+    // Whichever thread presents, once per frame after the last window swapped.
+    void OnPresent();
+
+    // Any thread.
+    FrameTimingStats GetStats() const;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    PresentMode mode_ = PresentMode::VSync;
+    float target_fps_ = 60.0f;
+    Clock::time_point next_frame_{};
+    bool scheduled_ = false;
+
+    mutable std::mutex mutex_;
+    std::array<float, kHistory> intervals_{};
+    size_t interval_count_ = 0;
+    size_t next_interval_ = 0;
+    Clock::time_point last_present_{};
+    bool presented_ = false;
+  };
+
+} // namespace wlw::rendering
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "core/vertex_2d.h"
+#include "core/vertex_3d.h"
+#include "core/packed_vertex_3d.h"
+
+namespace wlw::rendering {
+
+  enum class VertexLayout : uint8_t {
+    Vertex2D = 0,
+    Vertex3D = 1,
+    Packed3D = 2, // core::PackedVertex3D
+    Count
+  };
+
+  // Chosen per mesh from its vertex count; arenas hold indices of any width side by side.
+  enum class IndexType : uint8_t {
+    UInt16,
+    UInt32,
+  };
+
+  inline uint32_t GetIndexSize(IndexType type) {
+    return type == IndexType::UInt16 ? sizeof(uint16_t) : sizeof(uint32_t);
+  }
+
+  inline IndexType SelectIndexType(uint32_t vertex_count) {
+    return vertex_count <= 0x10000u ? IndexType::UInt16 : IndexType::UInt32;
+  }
+
+  // Where a mesh lives inside the pool: which arena, and the (offset, count) of its vertices and indices.
+  struct GeometryRange {
+    VertexLayout layout = VertexLayout::Vertex3D;
+    IndexType index_type = IndexType::UInt32;
+    uint32_t arena = 0;
+    uint32_t base_vertex = 0;
+    uint32_t vertex_count = 0;
+    uint32_t index_offset = 0; // in bytes, aligned to the index size
+    uint32_t index_count = 0;
+  };
+
+  // Part of a range's indices, counted in indices from the range's first one (e.g. the meshlets that survived culling).
+  struct IndexRange {
+    uint32_t first_index = 0;
+    uint32_t index_count = 0;
+  };
+
+  // A sub-allocation handed out by the GeometryPool. Releasing it returns the range to the arena.
+  class GeometryAllocation {
+  public:
+    virtual ~GeometryAllocation() = default;
+
+    const GeometryRange& GetRange() const {
+      return range_;
+    }
+
+    // False until the vertex / index data has reached the GPU; not-ready ranges must not be drawn.
+    virtual bool IsReady() const { return true; }
+
+    // Quantized layouts store positions as offset + value * scale; the model matrix has to apply it.
+    bool HasPositionTransform() const { return range_.layout == VertexLayout::Packed3D; }
+    const glm::vec3& GetPositionOffset() const { return position_offset_; }
+    const glm::vec3& GetPositionScale() const { return position_scale_; }
+
+    // `model` followed by the dequantization of this range's positions.
+    glm::mat4 ApplyPositionTransform(const glm::mat4& model) const {
+      if (!HasPositionTransform()) {
+        return model;
+      }
+      glm::mat4 result = model;
+      result[0] *= position_scale_.x;
+      result[1] *= position_scale_.y;
+      result[2] *= position_scale_.z;
+      result[3] += model[0] * position_offset_.x + model[1] * position_offset_.y + model[2] * position_offset_.z;
+      return result;
+    }
+
+  protected:
+    GeometryRange range_;
+    glm::vec3 position_offset_ = glm::vec3(0.0f);
+    glm::vec3 position_scale_ = glm::vec3(1.0f);
+  };
+
+  struct GeometryPoolStats {
+    uint32_t arena_count = 0;
+    uint32_t allocation_count = 0;
+    size_t vertex_bytes_used = 0;
+    size_t vertex_bytes_reserved = 0;
+    size_t index_bytes_used = 0;
+    size_t index_bytes_reserved = 0;
+  };
+
+  // A few large vertex/index arenas per vertex layout. Every arena has a single VAO, so meshes
+  // sharing an arena can be drawn back to back without rebinding any vertex state.
+  class GeometryPool {
+  public:
+    virtual ~GeometryPool() = default;
+
+    virtual std::unique_ptr<GeometryAllocation> Allocate(const std::vector<core::Vertex3D>& vertices, const std::vector<uint32_t>& indices) = 0;
+    virtual std::unique_ptr<GeometryAllocation> Allocate(const std::vector<core::Vertex2D>& vertices, const std::vector<uint32_t>& indices) = 0;
+    virtual std::unique_ptr<GeometryAllocation> Allocate(const core::PackedVertices3D& vertices, const std::vector<uint32_t>& indices) = 0;
+
+    // Binds the shared vertex state of the arena the range lives in (no-op if it is already bound).
+    virtual void Bind(const GeometryRange& range) = 0;
+    virtual void Unbind() = 0;
+
+    virtual GeometryPoolStats GetStats() const = 0;
+  };
+
+} // namespace wlw::rendering
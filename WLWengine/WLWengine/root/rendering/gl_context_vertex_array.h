@@ -0,0 +1,63 @@
+#ifdef WLW_USE_GLFW
+
+#pragma once
+
+#include <functional>
+#include <utility>
+#include <vector>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+namespace wlw::rendering {
+
+  // Buffers and textures are shared between the windows' contexts, but VAOs are container objects and
+  // are not: a VAO is only valid in the context that created it. This keeps one per context, created
+  // from `setup` (called with the new VAO bound) the first time a context binds it. Drawing thread only.
+  class GLContextVertexArray {
+  public:
+    explicit GLContextVertexArray(std::function<void()> setup = nullptr) : setup_(std::move(setup)) {}
+
+    // Only the current context's VAO can be deleted here; the others go away with their contexts.
+    ~GLContextVertexArray() {
+      GLFWwindow* context = glfwGetCurrentContext();
+      for (const auto& [owner, vao] : vertex_arrays_) {
+        if (owner == context) {
+          glDeleteVertexArrays(1, &vao);
+        }
+      }
+    }
+
+    GLContextVertexArray(const GLContextVertexArray&) = delete;
+    GLContextVertexArray& operator=(const GLContextVertexArray&) = delete;
+
+    void Bind() {
+      glBindVertexArray(Get());
+    }
+
+    GLuint Get() {
+      GLFWwindow* context = glfwGetCurrentContext();
+      // A handful of windows at most; a linear scan beats hashing.
+      for (const auto& [owner, vao] : vertex_arrays_) {
+        if (owner == context) {
+          return vao;
+        }
+      }
+
+      GLuint vao = 0;
+      glGenVertexArrays(1, &vao);
+      glBindVertexArray(vao);
+      if (setup_) {
+        setup_();
+      }
+      vertex_arrays_.emplace_back(context, vao);
+      return vao;
+    }
+
+  private:
+    std::function<void()> setup_;
+    std::vector<std::pair<GLFWwindow*, GLuint>> vertex_arrays_;
+  };
+
+} // namespace wlw::rendering
+
+#endif // WLW_USE_GLFW
@@ -0,0 +1,309 @@
+#ifdef WLW_USE_GLFW
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+
+#include "rendering/geometry_pool.h"
+#include "rendering/gl_context_vertex_array.h"
+#include "rendering/gl_upload_thread.h"
+#include "utils/range_allocator.h"
+#include "core/vertex_2d.h"
+#include "core/vertex_3d.h"
+
+namespace wlw::rendering {
+
+  // One VBO + EBO pair, plus a VAO per context that already references both, so binding the VAO is all a draw needs.
+  // The index buffer is allocated in bytes so 16 and 32-bit index ranges can share it.
+  class GLGeometryArena {
+  public:
+    GLGeometryArena(VertexLayout layout, uint32_t vertex_capacity, uint32_t index_bytes)
+      : layout_(layout), vertices_(vertex_capacity), indices_(index_bytes), vertex_array_([this]() { SetupVertexArray(); }) {
+      vertex_stride_ = GetLayoutStride(layout);
+
+      glGenBuffers(1, &vbo_);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, vbo_);
+      glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)vertex_capacity * vertex_stride_, nullptr, GL_STATIC_DRAW);
+
+      glGenBuffers(1, &ebo_);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, ebo_);
+      glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)index_bytes, nullptr, GL_STATIC_DRAW);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    ~GLGeometryArena() {
+      glDeleteBuffers(1, &vbo_);
+      glDeleteBuffers(1, &ebo_);
+    }
+
+    // Allocation bookkeeping is locked: allocations are freed by mesh destructors on whichever thread
+    // drops the mesh, while the render thread allocates.
+    bool TryAllocate(uint32_t vertex_count, uint32_t index_count, IndexType index_type, GeometryRange& out_range) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      uint32_t base_vertex = vertices_.Allocate(vertex_count);
+      if (base_vertex == utils::RangeAllocator::kInvalidOffset) {
+        return false;
+      }
+      uint32_t index_size = GetIndexSize(index_type);
+      uint32_t index_offset = indices_.Allocate(index_count * index_size, index_size);
+      if (index_offset == utils::RangeAllocator::kInvalidOffset) {
+        vertices_.Free(base_vertex, vertex_count);
+        return false;
+      }
+
+      out_range.layout = layout_;
+      out_range.index_type = index_type;
+      out_range.base_vertex = base_vertex;
+      out_range.vertex_count = vertex_count;
+      out_range.index_offset = index_offset;
+      out_range.index_count = index_count;
+      allocation_count_++;
+      return true;
+    }
+
+    void Free(const GeometryRange& range) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      vertices_.Free(range.base_vertex, range.vertex_count);
+      indices_.Free(range.index_offset, range.index_count * GetIndexSize(range.index_type));
+      allocation_count_--;
+    }
+
+    // `indices` are already in range.index_type.
+    void Upload(const GeometryRange& range, const void* vertices, const void* indices) {
+      // GL_COPY_WRITE_BUFFER keeps us from disturbing whatever VAO / element binding is current.
+      glBindBuffer(GL_COPY_WRITE_BUFFER, vbo_);
+      glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)range.base_vertex * vertex_stride_, (GLsizeiptr)range.vertex_count * vertex_stride_, vertices);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, ebo_);
+      glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)range.index_offset, (GLsizeiptr)range.index_count * GetIndexSize(range.index_type), indices);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    // Binds the current context's VAO, creating it the first time this context draws from the arena.
+    void Bind() {
+      vertex_array_.Bind();
+    }
+
+    uint32_t GetVertexStride() const {
+      return vertex_stride_;
+    }
+
+    void AccumulateStats(GeometryPoolStats& stats) const {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stats.arena_count++;
+      stats.allocation_count += allocation_count_;
+      stats.vertex_bytes_used += (size_t)vertices_.GetUsed() * vertex_stride_;
+      stats.vertex_bytes_reserved += (size_t)vertices_.GetCapacity() * vertex_stride_;
+      stats.index_bytes_used += indices_.GetUsed();
+      stats.index_bytes_reserved += indices_.GetCapacity();
+    }
+
+    static uint32_t GetLayoutStride(VertexLayout layout) {
+      switch (layout) {
+      case VertexLayout::Vertex3D: return sizeof(core::Vertex3D);
+      case VertexLayout::Packed3D: return sizeof(core::PackedVertex3D);
+      default: return sizeof(core::Vertex2D);
+      }
+    }
+
+  private:
+    void SetupVertexArray() {
+      glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+      // The element buffer binding is part of the VAO state, unlike GL_ARRAY_BUFFER.
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+
+      if (layout_ == VertexLayout::Vertex3D) {
+        // Position (3 floats), Color (4 floats), Normal (3 floats), UV (2 floats)
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(core::Vertex3D), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(core::Vertex3D), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(core::Vertex3D), (void*)(7 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(core::Vertex3D), (void*)(10 * sizeof(float)));
+        glEnableVertexAttribArray(3);
+      }
+      else if (layout_ == VertexLayout::Packed3D) {
+        // Position (3 int16, read as float integers), Color (RGBA8 normalized), Normal (2 int16 octahedral), UV (2 halves)
+        glVertexAttribPointer(0, 3, GL_SHORT, GL_FALSE, sizeof(core::PackedVertex3D), (void*)offsetof(core::PackedVertex3D, position));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(core::PackedVertex3D), (void*)offsetof(core::PackedVertex3D, color));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_SHORT, GL_FALSE, sizeof(core::PackedVertex3D), (void*)offsetof(core::PackedVertex3D, normal));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(3, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(core::PackedVertex3D), (void*)offsetof(core::PackedVertex3D, texCoords));
+        glEnableVertexAttribArray(3);
+      }
+      else {
+        // Position (2 floats), Color (4 floats)
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(core::Vertex2D), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(core::Vertex2D), (void*)(2 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+      }
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    VertexLayout layout_;
+    uint32_t vertex_stride_ = 0;
+    uint32_t allocation_count_ = 0;
+
+    GLuint vbo_ = 0;
+    GLuint ebo_ = 0;
+
+    mutable std::mutex mutex_;
+    utils::RangeAllocator vertices_;
+    utils::RangeAllocator indices_; // bytes
+    GLContextVertexArray vertex_array_;
+  };
+
+  class GLGeometryAllocation : public GeometryAllocation {
+  public:
+    GLGeometryAllocation(std::weak_ptr<GLGeometryArena> arena, const GeometryRange& range, std::shared_ptr<GLUploadTicket> ticket)
+      : arena_(arena), ticket_(std::move(ticket)) {
+      range_ = range;
+    }
+
+    bool IsReady() const override {
+      return ticket_ == nullptr || ticket_->IsComplete();
+    }
+
+    void SetPositionTransform(const glm::vec3& offset, const glm::vec3& scale) {
+      position_offset_ = offset;
+      position_scale_ = scale;
+    }
+
+    ~GLGeometryAllocation() override {
+      // The pool may already be gone (e.g. meshes outliving the engine); its arenas took the ranges with them.
+      if (auto arena = arena_.lock()) {
+        arena->Free(range_);
+      }
+    }
+
+  private:
+    std::weak_ptr<GLGeometryArena> arena_;
+    std::shared_ptr<GLUploadTicket> ticket_; // null when uploaded inline
+  };
+
+  class GLGeometryPool : public GeometryPool {
+  public:
+    // Default arena sizes: 256K vertices (12 MB of Vertex3D) / 4 MB of indices. Bigger meshes get a dedicated arena.
+    static constexpr uint32_t kVertexArenaCapacity = 1u << 18;
+    static constexpr uint32_t kIndexArenaBytes = 4u << 20;
+
+    std::unique_ptr<GeometryAllocation> Allocate(const std::vector<core::Vertex3D>& vertices, const std::vector<uint32_t>& indices) override {
+      return AllocateImpl(VertexLayout::Vertex3D, vertices.data(), (uint32_t)vertices.size(), indices);
+    }
+
+    std::unique_ptr<GeometryAllocation> Allocate(const std::vector<core::Vertex2D>& vertices, const std::vector<uint32_t>& indices) override {
+      return AllocateImpl(VertexLayout::Vertex2D, vertices.data(), (uint32_t)vertices.size(), indices);
+    }
+
+    std::unique_ptr<GeometryAllocation> Allocate(const core::PackedVertices3D& vertices, const std::vector<uint32_t>& indices) override {
+      auto allocation = AllocateImpl(VertexLayout::Packed3D, vertices.vertices.data(), (uint32_t)vertices.vertices.size(), indices);
+      if (allocation) {
+        const auto& offset = vertices.position_offset;
+        const auto& scale = vertices.position_scale;
+        allocation->SetPositionTransform(glm::vec3(offset.x, offset.y, offset.z), glm::vec3(scale.x, scale.y, scale.z));
+      }
+      return allocation;
+    }
+
+    void Bind(const GeometryRange& range) override {
+      const auto& arena = arenas_[(size_t)range.layout][range.arena];
+      if (arena.get() == bound_arena_) {
+        return;
+      }
+      arena->Bind();
+      bound_arena_ = arena.get();
+    }
+
+    void Unbind() override {
+      glBindVertexArray(0);
+      bound_arena_ = nullptr;
+    }
+
+    // Arenas are still created, and their VAOs bound, on the drawing thread; only the data goes through `upload_thread`.
+    void SetUploadThread(GLUploadThread* upload_thread) {
+      upload_thread_ = upload_thread;
+    }
+
+    GeometryPoolStats GetStats() const override {
+      GeometryPoolStats stats;
+      for (const auto& layout_arenas : arenas_) {
+        for (const auto& arena : layout_arenas) {
+          arena->AccumulateStats(stats);
+        }
+      }
+      return stats;
+    }
+
+  private:
+    std::unique_ptr<GLGeometryAllocation> AllocateImpl(VertexLayout layout, const void* vertex_data, uint32_t vertex_count, const std::vector<uint32_t>& indices) {
+      uint32_t index_count = (uint32_t)indices.size();
+      if (vertex_count == 0 || index_count == 0) {
+        return nullptr;
+      }
+
+      // Meshes keep 32-bit indices on the CPU; most fit in 16 bits on the GPU.
+      IndexType index_type = SelectIndexType(vertex_count);
+      std::vector<uint16_t> narrow_indices;
+      const void* index_data = indices.data();
+      if (index_type == IndexType::UInt16) {
+        narrow_indices.assign(indices.begin(), indices.end());
+        index_data = narrow_indices.data();
+      }
+
+      auto& layout_arenas = arenas_[(size_t)layout];
+      GeometryRange range;
+      for (uint32_t i = 0; i < layout_arenas.size(); ++i) {
+        if (layout_arenas[i]->TryAllocate(vertex_count, index_count, index_type, range)) {
+          range.arena = i;
+          return Upload(layout_arenas[i], range, vertex_data, index_data);
+        }
+      }
+
+      uint32_t index_bytes = std::max(kIndexArenaBytes, index_count * GetIndexSize(index_type));
+      auto arena = std::make_shared<GLGeometryArena>(layout, std::max(kVertexArenaCapacity, vertex_count), index_bytes);
+      arena->TryAllocate(vertex_count, index_count, index_type, range);
+      range.arena = (uint32_t)layout_arenas.size();
+      layout_arenas.push_back(arena);
+      return Upload(arena, range, vertex_data, index_data);
+    }
+
+    std::unique_ptr<GLGeometryAllocation> Upload(const std::shared_ptr<GLGeometryArena>& arena, const GeometryRange& range, const void* vertex_data, const void* index_data) {
+      if (upload_thread_ == nullptr || !upload_thread_->IsRunning()) {
+        arena->Upload(range, vertex_data, index_data);
+        return std::make_unique<GLGeometryAllocation>(arena, range, nullptr);
+      }
+
+      // The mesh may change or die before the upload runs, so the task owns a copy of its data.
+      const uint8_t* vertex_bytes = static_cast<const uint8_t*>(vertex_data);
+      std::vector<uint8_t> vertices(vertex_bytes, vertex_bytes + (size_t)range.vertex_count * arena->GetVertexStride());
+      const uint8_t* index_bytes = static_cast<const uint8_t*>(index_data);
+      std::vector<uint8_t> indices(index_bytes, index_bytes + (size_t)range.index_count * GetIndexSize(range.index_type));
+      std::weak_ptr<GLGeometryArena> weak_arena = arena;
+      auto ticket = std::make_shared<GLUploadTicket>();
+
+      upload_thread_->Submit([weak_arena, range, vertices = std::move(vertices), indices = std::move(indices)]() {
+        if (auto target = weak_arena.lock()) {
+          target->Upload(range, vertices.data(), indices.data());
+        }
+      }, ticket);
+      return std::make_unique<GLGeometryAllocation>(arena, range, ticket);
+    }
+
+    std::array<std::vector<std::shared_ptr<GLGeometryArena>>, (size_t)VertexLayout::Count> arenas_;
+    const GLGeometryArena* bound_arena_ = nullptr; // per context too, so the driver unbinds after each window
+    GLUploadThread* upload_thread_ = nullptr;
+  };
+
+} // namespace wlw::rendering
+
+#endif // WLW_USE_GLFW
@@ -0,0 +1,95 @@
+#ifdef WLW_USE_GLFW
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <glad/glad.h>
+
+#include "rendering/render_stats.h"
+
+namespace wlw::rendering {
+
+  // GL_TIME_ELAPSED queries around each pass. Queries live in a ring of kFrameLatency frames and a frame's
+  // results are only read when its slot comes around again, by which point the GPU has long finished it,
+  // so reading never stalls the pipeline. Results the GPU still has not produced are dropped, not waited on.
+  class GLGpuTimer {
+  public:
+    static constexpr uint32_t kFrameLatency = 4;
+    static constexpr size_t kPassCount = (size_t)RenderPass::Count;
+
+    void Initialize() {
+      for (auto& frame : frames_) {
+        glGenQueries((GLsizei)kPassCount, frame.queries.data());
+      }
+    }
+
+    ~GLGpuTimer() {
+      if (frames_[0].queries[0] != 0) {
+        for (auto& frame : frames_) {
+          glDeleteQueries((GLsizei)kPassCount, frame.queries.data());
+        }
+      }
+    }
+
+    // Resolves the oldest frame in the ring (if its results are in) and starts recording into its slot.
+    // Returns true when `resolved` was filled.
+    bool BeginFrame(RenderStats& resolved) {
+      FrameQueries& frame = frames_[frame_index_ % kFrameLatency];
+      bool has_results = frame.issued != 0 && Resolve(frame, resolved);
+
+      frame.issued = 0;
+      frame.frame = frame_index_++;
+      return has_results;
+    }
+
+    void BeginPass(RenderPass pass) {
+      FrameQueries& frame = CurrentFrame();
+      glBeginQuery(GL_TIME_ELAPSED, frame.queries[(size_t)pass]);
+      frame.issued |= 1u << (uint32_t)pass;
+    }
+
+    void EndPass() {
+      glEndQuery(GL_TIME_ELAPSED);
+    }
+
+  private:
+    struct FrameQueries {
+      std::array<GLuint, kPassCount> queries{};
+      uint32_t issued = 0; // bit per pass recorded this frame
+      uint64_t frame = 0;
+    };
+
+    FrameQueries& CurrentFrame() {
+      return frames_[(frame_index_ - 1) % kFrameLatency];
+    }
+
+    static bool Resolve(const FrameQueries& frame, RenderStats& resolved) {
+      RenderStats stats;
+      for (size_t pass = 0; pass < kPassCount; ++pass) {
+        if (!(frame.issued & (1u << pass))) {
+          continue;
+        }
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(frame.queries[pass], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE) {
+          return false;
+        }
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(frame.queries[pass], GL_QUERY_RESULT, &nanoseconds);
+        stats.gpu_milliseconds[pass] = (float)(nanoseconds / 1.0e6);
+        stats.gpu_total_milliseconds += stats.gpu_milliseconds[pass];
+      }
+      stats.gpu_frame = frame.frame;
+      stats.gpu_timers_available = true;
+      resolved = stats;
+      return true;
+    }
+
+    std::array<FrameQueries, kFrameLatency> frames_{};
+    uint64_t frame_index_ = 0;
+  };
+
+} // namespace wlw::rendering
+
+#endif // WLW_USE_GLFW
@@ -0,0 +1,216 @@
+#ifdef WLW_USE_GLFW
+
+#include "gl_program_cache.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <GLFW/glfw3.h>
+
+// GL 4.1 / ARB_get_program_binary; our glad is 3.3 core only, so the entry points are resolved by hand.
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+namespace wlw::rendering {
+
+  typedef void (APIENTRYP PFNWLWGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+  typedef void (APIENTRYP PFNWLWPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+  typedef void (APIENTRYP PFNWLWPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+
+  static PFNWLWGETPROGRAMBINARYPROC wlwGetProgramBinary = nullptr;
+  static PFNWLWPROGRAMBINARYPROC wlwProgramBinary = nullptr;
+  static PFNWLWPROGRAMPARAMETERIPROC wlwProgramParameteri = nullptr;
+
+  static constexpr uint32_t kCacheMagic = 0x42505757; // "WWPB"
+
+  struct CacheFileHeader {
+    uint32_t magic;
+    uint32_t format;
+    uint64_t key;
+    uint32_t length;
+  };
+
+  // FNV-1a, 64 bit.
+  static uint64_t HashString(const std::string& text, uint64_t hash = 14695981039346656037ull) {
+    for (unsigned char c : text) {
+      hash ^= c;
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+  static std::string GetGLString(GLenum name) {
+    const GLubyte* value = glGetString(name);
+    return value ? reinterpret_cast<const char*>(value) : "";
+  }
+
+  GLProgramCache::GLProgramCache(std::string directory) : directory_(std::move(directory)) {}
+
+  void GLProgramCache::Initialize() {
+    driver_id_ = GetGLString(GL_VENDOR) + "|" + GetGLString(GL_RENDERER) + "|" + GetGLString(GL_VERSION);
+
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    bool has_entry_points = (major > 4 || (major == 4 && minor >= 1)) || glfwExtensionSupported("GL_ARB_get_program_binary");
+
+    if (has_entry_points) {
+      wlwGetProgramBinary = (PFNWLWGETPROGRAMBINARYPROC)glfwGetProcAddress("glGetProgramBinary");
+      wlwProgramBinary = (PFNWLWPROGRAMBINARYPROC)glfwGetProcAddress("glProgramBinary");
+      wlwProgramParameteri = (PFNWLWPROGRAMPARAMETERIPROC)glfwGetProcAddress("glProgramParameteri");
+    }
+
+    // Some drivers expose the entry points but no formats, which means no binary will ever be returned.
+    GLint format_count = 0;
+    if (wlwGetProgramBinary && wlwProgramBinary && wlwProgramParameteri) {
+      glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+    }
+    binary_supported_ = format_count > 0;
+
+    if (binary_supported_) {
+      std::error_code error;
+      std::filesystem::create_directories(directory_, error);
+    }
+  }
+
+  GLuint GLProgramCache::GetProgram(const std::string& vertex_source, const std::string& fragment_source) {
+    auto start = std::chrono::steady_clock::now();
+
+    uint64_t key = HashString(driver_id_, HashString(fragment_source, HashString(vertex_source)));
+    std::ostringstream path;
+    path << directory_ << "/" << std::hex << key << ".bin";
+
+    GLuint program = binary_supported_ ? LoadBinary(path.str(), key) : 0;
+    if (program != 0) {
+      stats_.loaded++;
+    }
+    else {
+      program = Compile(vertex_source, fragment_source);
+      if (program != 0) {
+        stats_.compiled++;
+        if (binary_supported_) {
+          StoreBinary(path.str(), key, program);
+        }
+      }
+    }
+
+    stats_.milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return program;
+  }
+
+  GLuint GLProgramCache::LoadBinary(const std::string& path, uint64_t key) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+      return 0;
+    }
+
+    CacheFileHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != kCacheMagic || header.key != key) {
+      return 0;
+    }
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size())) {
+      return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    wlwProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+
+    // The driver may reject a binary it produced itself (e.g. after an update that kept the version string).
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked == GL_FALSE) {
+      glDeleteProgram(program);
+      return 0;
+    }
+    return program;
+  }
+
+  void GLProgramCache::StoreBinary(const std::string& path, uint64_t key, GLuint program) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+      return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    wlwGetProgramBinary(program, length, &length, &format, binary.data());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      std::cerr << "Could not write shader cache entry " << path << std::endl;
+      return;
+    }
+    CacheFileHeader header{ kCacheMagic, format, key, (uint32_t)length };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), length);
+  }
+
+  static GLuint CompileShader(GLenum type, const char* source) {
+    GLuint id = glCreateShader(type);
+    glShaderSource(id, 1, &source, nullptr);
+    glCompileShader(id);
+
+    int result;
+    glGetShaderiv(id, GL_COMPILE_STATUS, &result);
+    if (result == GL_FALSE) {
+      int length;
+      glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
+      std::vector<char> message(length);
+      glGetShaderInfoLog(id, length, &length, message.data());
+      std::cerr << "Failed to compile shader (" << (type == GL_VERTEX_SHADER ? "Vertex" : "Fragment") << "):" << std::endl;
+      std::cerr << message.data() << std::endl;
+      glDeleteShader(id);
+      return 0;
+    }
+    return id;
+  }
+
+  GLuint GLProgramCache::Compile(const std::string& vertex_source, const std::string& fragment_source) {
+    GLuint vs = CompileShader(GL_VERTEX_SHADER, vertex_source.c_str());
+    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, fragment_source.c_str());
+    if (vs == 0 || fs == 0) {
+      glDeleteShader(vs);
+      glDeleteShader(fs);
+      return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    if (binary_supported_) {
+      wlwProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
+
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked == GL_FALSE) {
+      int length;
+      glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+      std::vector<char> message(length + 1);
+      glGetProgramInfoLog(program, length, &length, message.data());
+      std::cerr << "Failed to link program:" << std::endl << message.data() << std::endl;
+      glDeleteProgram(program);
+      return 0;
+    }
+    return program;
+  }
+
+} // namespace wlw::rendering
+
+#endif // WLW_USE_GLFW
@@ -0,0 +1,46 @@
+#ifdef WLW_USE_GLFW
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <glad/glad.h>
+
+namespace wlw::rendering {
+
+  // Links GL programs from source, or loads the driver's own binary from disk when the same sources were
+  // already linked by the same driver. Entries are keyed by a hash of the sources plus GL vendor, renderer
+  // and version, so a driver update or a shader edit simply misses and recompiles.
+  class GLProgramCache {
+  public:
+    struct Stats {
+      uint32_t loaded = 0;   // programs restored from a cached binary
+      uint32_t compiled = 0; // programs compiled from source (and stored, when binaries are supported)
+      double milliseconds = 0.0;
+    };
+
+    explicit GLProgramCache(std::string directory = "shader_cache");
+
+    // Resolves the program binary entry points and the driver identity. Needs a current context.
+    void Initialize();
+
+    // Returns 0 if the sources fail to compile or link.
+    GLuint GetProgram(const std::string& vertex_source, const std::string& fragment_source);
+
+    bool IsBinarySupported() const { return binary_supported_; }
+    const Stats& GetStats() const { return stats_; }
+
+  private:
+    GLuint LoadBinary(const std::string& path, uint64_t key);
+    void StoreBinary(const std::string& path, uint64_t key, GLuint program);
+    GLuint Compile(const std::string& vertex_source, const std::string& fragment_source);
+
+    std::string directory_;
+    std::string driver_id_;
+    bool binary_supported_ = false;
+    Stats stats_;
+  };
+
+} // namespace wlw::rendering
+
+#endif // WLW_USE_GLFW
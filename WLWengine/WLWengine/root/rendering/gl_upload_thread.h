@@ -0,0 +1,159 @@
+#ifdef WLW_USE_GLFW
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+namespace wlw::rendering {
+
+  // Completion of one upload. The upload thread signals it with a fence right after issuing the GL calls;
+  // the consumer polls it (never blocks) and only uses the resource once the GPU has passed the fence.
+  class GLUploadTicket {
+  public:
+    ~GLUploadTicket() {
+      // A fence nobody waited on; it can only be deleted where some context of the share group is current.
+      if (fence_ && glfwGetCurrentContext() != nullptr) {
+        glDeleteSync(fence_);
+      }
+    }
+
+    // Upload thread (or inline uploads, with a null fence).
+    void Signal(GLsync fence) {
+      fence_ = fence;
+      submitted_.store(true, std::memory_order_release);
+    }
+
+    // Consumer thread, with a context of the share group current.
+    bool IsComplete() const {
+      if (!submitted_.load(std::memory_order_acquire)) {
+        return false;
+      }
+      if (fence_) {
+        GLenum status = glClientWaitSync(fence_, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+          return false;
+        }
+        glDeleteSync(fence_);
+        fence_ = nullptr;
+      }
+      return true;
+    }
+
+  private:
+    std::atomic<bool> submitted_ = false;
+    mutable GLsync fence_ = nullptr;
+  };
+
+  // A worker with its own hidden context, shared with the main one, that creates and fills textures and
+  // buffers so loading never stalls the thread that draws. Buffer and texture names are shared across the
+  // share group; container objects (VAOs) are not, so those stay with the drawing context.
+  class GLUploadThread {
+  public:
+    ~GLUploadThread() {
+      Stop();
+    }
+
+    // Main thread (GLFW window creation), with the context to share with current.
+    bool Start() {
+      GLFWwindow* share = glfwGetCurrentContext();
+      if (share == nullptr || thread_.joinable()) {
+        return false;
+      }
+
+      glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+      context_ = glfwCreateWindow(1, 1, "wlw upload context", nullptr, share);
+      glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+      if (context_ == nullptr) {
+        return false;
+      }
+
+      stopping_ = false;
+      thread_ = std::thread([this]() { Loop(); });
+      return true;
+    }
+
+    // Main thread. Runs whatever was already submitted, then tears the context down.
+    void Stop() {
+      if (!thread_.joinable()) {
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+      }
+      condition_.notify_one();
+      thread_.join();
+
+      glfwDestroyWindow(context_);
+      context_ = nullptr;
+    }
+
+    bool IsRunning() const {
+      return thread_.joinable();
+    }
+
+    // Runs `upload` on the upload context and signals `ticket` once the commands are flushed.
+    // Without a running thread the upload runs inline and the caller must have a context current.
+    void Submit(std::function<void()> upload, std::shared_ptr<GLUploadTicket> ticket) {
+      if (!IsRunning()) {
+        upload();
+        ticket->Signal(nullptr);
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push({ std::move(upload), std::move(ticket) });
+      }
+      condition_.notify_one();
+    }
+
+  private:
+    struct Task {
+      std::function<void()> upload;
+      std::shared_ptr<GLUploadTicket> ticket;
+    };
+
+    void Loop() {
+      glfwMakeContextCurrent(context_);
+
+      while (true) {
+        Task task;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+          if (tasks_.empty()) {
+            break;
+          }
+          task = std::move(tasks_.front());
+          tasks_.pop();
+        }
+
+        task.upload();
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        // The fence has to reach the GPU before another context can see it signal.
+        glFlush();
+        task.ticket->Signal(fence);
+      }
+
+      glfwMakeContextCurrent(nullptr);
+    }
+
+    GLFWwindow* context_ = nullptr;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::queue<Task> tasks_;
+    bool stopping_ = false;
+  };
+
+} // namespace wlw::rendering
+
+#endif // WLW_USE_GLFW
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "core/color.h"
+#include "core/vector3.h"
+
+namespace wlw::rendering {
+
+	enum class LightType {
+		Directional = 0,
+		Point = 1,
+		Spot = 2
+	};
+
+	struct Lighting {
+		LightType type = LightType::Point;
+		core::Vector3 position;
+		core::Vector3 direction = { 0.0f, -1.0f, 0.0f };
+
+		core::Color color = { 1.0f, 1.0f, 1.0f, 1.0f };
+		float ambient_strength = 0.1f;
+
+		float constant = 1.0f;
+		float linear = 0.09f;
+		float quadratic = 0.032f;
+		
+		float cutOff = 0.976f;      // cos(12.5)
+		float outerCutOff = 0.953f; // cos(17.5)
+
+		// Point / spot reach used for light culling; 0 derives it from the attenuation terms.
+		float range = 0.0f;
+	};
+
+} // namespace wlw::rendering
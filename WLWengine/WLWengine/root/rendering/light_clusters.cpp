@@ -0,0 +1,143 @@
+#include "light_clusters.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace wlw::rendering {
+
+  float LightClusterGrid::ComputeRange(const Lighting& light) {
+    if (light.range > 0.0f) {
+      return light.range;
+    }
+
+    // Distance at which the brightest channel falls below 1/256.
+    float brightness = std::max({ light.color.r, light.color.g, light.color.b, 1e-4f });
+    float threshold = 256.0f * brightness;
+    if (light.quadratic > 0.0f) {
+      // A light too dim to ever reach the threshold has no positive root: it lights nothing.
+      float c = light.constant - threshold;
+      float discriminant = light.linear * light.linear - 4.0f * light.quadratic * c;
+      if (c >= 0.0f || discriminant < 0.0f) {
+        return 0.0f;
+      }
+      return (-light.linear + std::sqrt(discriminant)) / (2.0f * light.quadratic);
+    }
+    if (light.linear > 0.0f) {
+      return std::max(0.0f, (threshold - light.constant) / light.linear);
+    }
+    return 1000.0f;
+  }
+
+  void LightClusterGrid::Build(const std::vector<Lighting>& lights, const glm::mat4& view, const glm::mat4& projection, const core::Vector2& viewport_size) {
+    light_data_.clear();
+    directional_lights_.clear();
+    bounds_.clear();
+    clusters_.assign(kClusterCount * 2, 0);
+    light_indices_.clear();
+
+    // Recover near / far from a GL perspective matrix.
+    float z_near = projection[3][2] / (projection[2][2] - 1.0f);
+    float z_far = projection[3][2] / (projection[2][2] + 1.0f);
+    float log_ratio = std::log(z_far / z_near);
+    slice_scale_bias_ = glm::vec2((float)kSlicesZ / log_ratio, -(float)kSlicesZ * std::log(z_near) / log_ratio);
+    tile_size_ = glm::vec2(std::max(1.0f, viewport_size.x / kTilesX), std::max(1.0f, viewport_size.y / kTilesY));
+
+    auto slice_of = [this](float depth) {
+      float slice = std::floor(std::log(depth) * slice_scale_bias_.x + slice_scale_bias_.y);
+      return (uint32_t)std::clamp(slice, 0.0f, (float)(kSlicesZ - 1));
+    };
+    auto tile_of = [](float ndc, uint32_t tiles) {
+      float tile = std::floor((ndc * 0.5f + 0.5f) * tiles);
+      return (uint32_t)std::clamp(tile, 0.0f, (float)(tiles - 1));
+    };
+
+    for (const auto& light : lights) {
+      if (light.type == LightType::Directional) {
+        if (directional_lights_.size() / 2 < kMaxDirectionalLights) {
+          glm::vec3 direction = glm::normalize(glm::vec3(light.direction));
+          directional_lights_.push_back(glm::vec4(direction, light.ambient_strength));
+          directional_lights_.push_back(glm::vec4(light.color.r, light.color.g, light.color.b, 0.0f));
+        }
+        continue;
+      }
+      if (bounds_.size() == kMaxLights) {
+        continue;
+      }
+
+      float range = ComputeRange(light);
+      if (range <= 0.0f) {
+        continue;
+      }
+      glm::vec3 center = glm::vec3(view * glm::vec4(glm::vec3(light.position), 1.0f));
+      float depth = -center.z;
+      if (depth + range < z_near || depth - range > z_far) {
+        continue;
+      }
+
+      LightBounds bounds;
+      bounds.z0 = slice_of(std::max(z_near, depth - range));
+      bounds.z1 = slice_of(std::min(z_far, depth + range));
+
+      if (depth - range <= z_near) {
+        // Straddles the camera plane: projected bounds are meaningless, cover the whole screen.
+        bounds.x0 = 0; bounds.x1 = kTilesX - 1;
+        bounds.y0 = 0; bounds.y1 = kTilesY - 1;
+      }
+      else {
+        // The projected corners of the view-space box bound the projected sphere.
+        glm::vec2 ndc_min(1.0f), ndc_max(-1.0f);
+        for (int corner = 0; corner < 8; ++corner) {
+          glm::vec3 offset((corner & 1) ? range : -range, (corner & 2) ? range : -range, (corner & 4) ? range : -range);
+          glm::vec4 clip = projection * glm::vec4(center + offset, 1.0f);
+          glm::vec2 ndc = glm::vec2(clip) / clip.w;
+          ndc_min = glm::min(ndc_min, ndc);
+          ndc_max = glm::max(ndc_max, ndc);
+        }
+        if (ndc_max.x < -1.0f || ndc_min.x > 1.0f || ndc_max.y < -1.0f || ndc_min.y > 1.0f) {
+          continue;
+        }
+        bounds.x0 = tile_of(ndc_min.x, kTilesX); bounds.x1 = tile_of(ndc_max.x, kTilesX);
+        bounds.y0 = tile_of(ndc_min.y, kTilesY); bounds.y1 = tile_of(ndc_max.y, kTilesY);
+      }
+
+      bounds.light = (uint32_t)(light_data_.size() / kTexelsPerLight);
+      bounds_.push_back(bounds);
+
+      glm::vec3 direction = glm::normalize(glm::vec3(light.direction));
+      light_data_.push_back(glm::vec4(glm::vec3(light.position), range));
+      light_data_.push_back(glm::vec4(light.color.r, light.color.g, light.color.b, light.ambient_strength));
+      light_data_.push_back(glm::vec4(direction, (float)light.type));
+      light_data_.push_back(glm::vec4(light.constant, light.linear, light.quadratic, 0.0f));
+      light_data_.push_back(glm::vec4(light.cutOff, light.outerCutOff, 0.0f, 0.0f));
+    }
+
+    auto for_each_cluster = [](const LightBounds& bounds, auto&& fn) {
+      for (uint32_t z = bounds.z0; z <= bounds.z1; ++z) {
+        for (uint32_t y = bounds.y0; y <= bounds.y1; ++y) {
+          for (uint32_t x = bounds.x0; x <= bounds.x1; ++x) {
+            fn((z * kTilesY + y) * kTilesX + x);
+          }
+        }
+      }
+    };
+
+    // Count, prefix sum into first-index slots, then scatter.
+    for (const auto& bounds : bounds_) {
+      for_each_cluster(bounds, [this](uint32_t cluster) { clusters_[cluster * 2 + 1]++; });
+    }
+    uint32_t total = 0;
+    for (uint32_t cluster = 0; cluster < kClusterCount; ++cluster) {
+      clusters_[cluster * 2] = total;
+      total += clusters_[cluster * 2 + 1];
+      clusters_[cluster * 2 + 1] = 0;
+    }
+    light_indices_.resize(total);
+    for (const auto& bounds : bounds_) {
+      for_each_cluster(bounds, [this, &bounds](uint32_t cluster) {
+        uint32_t& count = clusters_[cluster * 2 + 1];
+        light_indices_[clusters_[cluster * 2] + count++] = bounds.light;
+      });
+    }
+  }
+
+} // namespace wlw::rendering
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "core/vector2.h"
+#include "rendering/light.h"
+
+namespace wlw::rendering {
+
+  // Splits the view frustum into kTilesX x kTilesY screen tiles and kSlicesZ exponential depth slices,
+  // and lists per cluster the point / spot lights whose range touches it. Directional lights reach
+  // everything and are kept apart. Built on the CPU every frame; the shader only reads its cluster.
+  class LightClusterGrid {
+  public:
+    static constexpr uint32_t kTilesX = 16;
+    static constexpr uint32_t kTilesY = 9;
+    static constexpr uint32_t kSlicesZ = 24;
+    static constexpr uint32_t kClusterCount = kTilesX * kTilesY * kSlicesZ;
+
+    static constexpr uint32_t kMaxLights = 1024;
+    static constexpr uint32_t kMaxDirectionalLights = 4;
+
+    // Per clustered light: (position, range) (color, ambient) (direction, type) (constant, linear, quadratic, -)
+    // (cutOff, outerCutOff, -, -). Must match the fragment shader.
+    static constexpr uint32_t kTexelsPerLight = 5;
+
+    void Build(const std::vector<Lighting>& lights, const glm::mat4& view, const glm::mat4& projection, const core::Vector2& viewport_size);
+
+    const std::vector<glm::vec4>& GetLightData() const { return light_data_; }
+    const std::vector<uint32_t>& GetClusters() const { return clusters_; } // (first index, count) per cluster
+    const std::vector<uint32_t>& GetLightIndices() const { return light_indices_; }
+
+    // Two texels per light: (direction, ambient) (color, -).
+    const std::vector<glm::vec4>& GetDirectionalLights() const { return directional_lights_; }
+    uint32_t GetDirectionalLightCount() const { return (uint32_t)directional_lights_.size() / 2; }
+
+    // slice = log(view_depth) * x + y
+    glm::vec2 GetSliceScaleBias() const { return slice_scale_bias_; }
+    glm::vec2 GetTileSize() const { return tile_size_; }
+
+    static float ComputeRange(const Lighting& light);
+
+  private:
+    struct LightBounds {
+      uint32_t light;
+      uint32_t x0, x1, y0, y1, z0, z1;
+    };
+
+    std::vector<glm::vec4> light_data_;
+    std::vector<glm::vec4> directional_lights_;
+    std::vector<uint32_t> clusters_;
+    std::vector<uint32_t> light_indices_;
+    std::vector<LightBounds> bounds_;
+
+    glm::vec2 slice_scale_bias_ = glm::vec2(0.0f);
+    glm::vec2 tile_size_ = glm::vec2(1.0f);
+  };
+
+} // namespace wlw::rendering
@@ -1,39 +1,14 @@
 #pragma once
 
 #include <memory>
-#include <optional>
 #include <string>
 
-#include "rendering/texture.h"
 #include "core/color.h"
-#include "core/vector3.h"
+#include "rendering/texture.h"
+#include "rendering/light.h"
 
 namespace wlw::rendering {
 
-	enum class LightType {
-		Directional = 0,
-		Point = 1,
-		Spot = 2
-	};
-
-	struct Lighting {
-		LightType type = LightType::Point;
-		core::Vector3 position;
-		core::Vector3 direction = { 0.0f, -1.0f, 0.0f };
-
-		core::Color color = { 1.0f, 1.0f, 1.0f, 1.0f };
-		float ambient_strength;
-		float shininess;
-
-		float constant = 1.0f;
-		float linear = 0.09f;
-		float quadratic = 0.032f;
-		
-		float cutOff = 0.976f;      // cos(12.5)
-		float outerCutOff = 0.953f; // cos(17.5)
-	};
-
-
 	class Material {
 	public:
 
@@ -50,22 +25,41 @@ namespace wlw::rendering {
 			return texture_ != nullptr;
 		}
 
-		void SetLighting(const Lighting& lighting) {
-			lighting_ = lighting;
+		const std::shared_ptr<WTexture>& GetTexture() const {
+			return texture_;
+		}
+
+		// Lit materials are shaded by the window's lights (see scene::Window::AddLight).
+		void SetLit(bool lit) {
+			lit_ = lit;
+		}
+
+		bool IsLit() const {
+			return lit_;
+		}
+
+		// Single-sided materials have their back faces culled (counter-clockwise is front). Materials are
+		// double-sided unless they opt out, since the built-in meshes do not all share one winding.
+		void SetDoubleSided(bool double_sided) {
+			double_sided_ = double_sided;
 		}
 
-		std::optional<Lighting> GetLighting() const {
-			return lighting_;
+		bool IsDoubleSided() const {
+			return double_sided_;
 		}
 
 		static std::unique_ptr<Material> Create();
 
 		float metallic = 0.0f;
 		float roughness = 1.0f;
+		float shininess = 32.0f;
+		// Multiplies the vertex or texture color (glTF baseColorFactor); alpha is unused.
+		core::Color base_color = { 1.0f, 1.0f, 1.0f, 1.0f };
 		std::string name;
 
 	protected:
-		std::optional<Lighting> lighting_;
+		bool lit_ = false;
+		bool double_sided_ = true;
 		std::shared_ptr<WTexture> texture_;
 
 	};
@@ -9,6 +9,7 @@
 #include "core/vertex_3d.h"
 #include "utils/image_loader.h"
 #include "rendering/texture.h"
+#include "rendering/geometry_pool.h"
 
 namespace wlw::rendering {
 
@@ -25,6 +26,19 @@ public:
   virtual std::shared_ptr<WTexture2D> CreateTexture2D(const utils::RawImage& data) = 0;
   virtual std::shared_ptr<WCubemap> CreateCubemap(const std::array<utils::RawImage, 6>& faces) = 0;
 
+  // Called once by the driver, on the main thread, right after the main context became current.
+  virtual void InitializeContextResources() = 0;
+
+  // True when textures can be created from any thread (they upload in the background and report IsReady()).
+  virtual bool SupportsConcurrentCreation() const = 0;
+
+  // Shared vertex/index arenas meshes are sub-allocated from.
+  virtual GeometryPool* GetGeometryPool() = 0;
+
+  // Deletes GPU objects whose last reference was dropped on a thread without a current context.
+  // Call once per frame from the thread that owns the context.
+  virtual void ReleasePendingResources() = 0;
+
   static std::unique_ptr<RenderDevice> Create();
 };
 
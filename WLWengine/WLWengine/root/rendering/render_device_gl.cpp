@@ -1,16 +1,37 @@
 #ifdef WLW_USE_GLFW
 
+#include <iostream>
+#include <mutex>
+#include <vector>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "render_device.h"
 #include "rendering/gl_index_buffer.h"
 #include "rendering/gl_vertex_buffer.h"
+#include "rendering/gl_geometry_pool.h"
+#include "rendering/gl_upload_thread.h"
 
 namespace wlw::rendering {
 
+// With threaded rendering the update thread can drop the last reference to a texture (level switch, material
+// swap) while it has no context; those names are parked here until the render thread releases them.
+static std::mutex g_orphaned_textures_mutex;
+static std::vector<GLuint> g_orphaned_textures;
+
+static void DeleteTexture(GLuint id) {
+  if (glfwGetCurrentContext() == nullptr) {
+    std::lock_guard<std::mutex> lock(g_orphaned_textures_mutex);
+    g_orphaned_textures.push_back(id);
+    return;
+  }
+  glDeleteTextures(1, &id);
+}
+
+// Textures are filled on the upload thread when there is one; the ticket tells the render thread when
+// the pixels are in. gpu_id_ is written before the ticket is signalled and read only after it completes.
 class GLTexture2D : public WTexture2D {
 public:
-  GLTexture2D(const utils::RawImage& data) {
+  void Upload(const utils::RawImage& data) {
     glGenTextures(1, &gpu_id_);
     glBindTexture(GL_TEXTURE_2D, gpu_id_);
 
@@ -28,7 +49,17 @@ public:
   }
 
   ~GLTexture2D() {
-    glDeleteTextures(1, &gpu_id_);
+    if (gpu_id_ != 0) {
+      DeleteTexture(gpu_id_);
+    }
+  }
+
+  bool IsReady() const override {
+    return ticket_->IsComplete();
+  }
+
+  const std::shared_ptr<GLUploadTicket>& GetTicket() const {
+    return ticket_;
   }
 
   void Bind(unsigned int slot) const override {
@@ -39,11 +70,14 @@ public:
   void Unbind() const override {
     glBindTexture(GL_TEXTURE_2D, 0);
   }
+
+private:
+  std::shared_ptr<GLUploadTicket> ticket_ = std::make_shared<GLUploadTicket>();
 };
 
 class GLCubemap : public WCubemap {
 public:
-  GLCubemap(const std::array<utils::RawImage, 6>& faces) {
+  void Upload(const std::array<utils::RawImage, 6>& faces) {
     glGenTextures(1, &gpu_id_);
     glBindTexture(GL_TEXTURE_CUBE_MAP, gpu_id_);
 
@@ -61,7 +95,17 @@ public:
   }
 
   ~GLCubemap() {
-    glDeleteTextures(1, &gpu_id_);
+    if (gpu_id_ != 0) {
+      DeleteTexture(gpu_id_);
+    }
+  }
+
+  bool IsReady() const override {
+    return ticket_->IsComplete();
+  }
+
+  const std::shared_ptr<GLUploadTicket>& GetTicket() const {
+    return ticket_;
   }
 
   void Bind(unsigned int slot) const override {
@@ -72,6 +116,9 @@ public:
   void Unbind() const override {
     glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
   }
+
+private:
+  std::shared_ptr<GLUploadTicket> ticket_ = std::make_shared<GLUploadTicket>();
 };
 
 class GLRenderDevice : public RenderDevice {
@@ -89,12 +136,46 @@ public:
   }
 
   std::shared_ptr<WTexture2D> CreateTexture2D(const utils::RawImage& data) override {
-    return std::make_shared<GLTexture2D>(data);
+    auto texture = std::make_shared<GLTexture2D>();
+    upload_thread_.Submit([texture, data]() { texture->Upload(data); }, texture->GetTicket());
+    return texture;
   }
 
   std::shared_ptr<WCubemap> CreateCubemap(const std::array<utils::RawImage, 6>& faces) override {
-    return std::make_shared<GLCubemap>(faces);
+    auto cubemap = std::make_shared<GLCubemap>();
+    upload_thread_.Submit([cubemap, faces]() { cubemap->Upload(faces); }, cubemap->GetTicket());
+    return cubemap;
+  }
+
+  void InitializeContextResources() override {
+    if (!upload_thread_.Start()) {
+      std::cerr << "Could not create the upload context, resources will upload on the render thread" << std::endl;
+    }
+    geometry_pool_.SetUploadThread(&upload_thread_);
+  }
+
+  bool SupportsConcurrentCreation() const override {
+    return upload_thread_.IsRunning();
   }
+
+  GeometryPool* GetGeometryPool() override {
+    return &geometry_pool_;
+  }
+
+  void ReleasePendingResources() override {
+    std::vector<GLuint> textures;
+    {
+      std::lock_guard<std::mutex> lock(g_orphaned_textures_mutex);
+      textures.swap(g_orphaned_textures);
+    }
+    if (!textures.empty()) {
+      glDeleteTextures((GLsizei)textures.size(), textures.data());
+    }
+  }
+
+private:
+  GLGeometryPool geometry_pool_;
+  GLUploadThread upload_thread_; // declared last: stops before the pool and its arenas go away
 };
 
 std::unique_ptr<RenderDevice> RenderDevice::Create() {
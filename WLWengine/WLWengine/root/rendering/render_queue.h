@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include "rendering/command_list.h"
+#include "rendering/scene_snapshot.h"
+
+namespace wlw::rendering {
+
+  // One visible proxy of the snapshot being drawn. Pointers are only valid while that snapshot is.
+  struct RenderItem {
+    const RenderProxy* proxy = nullptr;
+    const GeometryAllocation* geometry = nullptr; // of the proxy's LOD, or its fallback while that uploads
+    uint32_t shader_variant = 0; // see shader_variant.h
+    float view_depth = 0.0f;     // distance along the camera forward axis, used for ordering
+
+    // The proxy's surviving meshlets in the snapshot; none means the whole mesh.
+    const IndexRange* index_ranges = nullptr;
+    uint32_t index_range_count = 0;
+
+    CullMode cull_mode = CullMode::None;
+  };
+
+  class RenderQueue {
+  public:
+    void Clear() {
+      items_.clear();
+    }
+
+    void Push(const RenderItem& item) {
+      items_.push_back(item);
+    }
+
+    // Grouped by shader variant so each program is bound once per bucket, then nearest first within a
+    // group so opaque geometry fills the depth buffer early and later fragments get rejected.
+    void Sort() {
+      std::stable_sort(items_.begin(), items_.end(), [](const RenderItem& a, const RenderItem& b) {
+        if (a.shader_variant != b.shader_variant) {
+          return a.shader_variant < b.shader_variant;
+        }
+        return a.view_depth < b.view_depth;
+      });
+    }
+
+    const std::vector<RenderItem>& GetItems() const {
+      return items_;
+    }
+
+    bool IsEmpty() const {
+      return items_.empty();
+    }
+
+  private:
+    std::vector<RenderItem> items_;
+  };
+
+} // namespace wlw::rendering
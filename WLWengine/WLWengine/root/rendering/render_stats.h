@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace wlw::rendering {
+
+  enum class RenderPass : uint8_t {
+    DepthPrePass,
+    Opaque,
+    Skybox,
+    Count
+  };
+
+  inline const char* GetRenderPassName(RenderPass pass) {
+    switch (pass) {
+    case RenderPass::DepthPrePass: return "depth pre-pass";
+    case RenderPass::Opaque: return "opaque";
+    case RenderPass::Skybox: return "skybox";
+    default: return "unknown";
+    }
+  }
+
+  struct RenderStats {
+    // GPU time per pass of the most recently resolved frame; a few frames old by design.
+    std::array<float, (size_t)RenderPass::Count> gpu_milliseconds{};
+    float gpu_total_milliseconds = 0.0f;
+    uint64_t gpu_frame = 0; // frame number the GPU timings belong to
+    bool gpu_timers_available = false;
+
+    // Geometry upload stage, as of the last drawn frame.
+    uint32_t pending_uploads = 0;
+    size_t pending_upload_bytes = 0;
+    size_t uploaded_bytes = 0; // moved into the geometry pool that frame
+
+    // Meshlet culling of the last drawn snapshot (only meshes split into meshlets count).
+    uint32_t visible_meshlets = 0;
+    uint32_t culled_meshlets = 0;
+
+    // Mesh memory: CPU copies of all live meshes (see core::MeshResidency) and what the geometry pool holds.
+    size_t mesh_cpu_bytes = 0;
+    size_t mesh_released_bytes = 0;
+    size_t geometry_gpu_bytes = 0;
+
+    float GetGpuMilliseconds(RenderPass pass) const {
+      return gpu_milliseconds[(size_t)pass];
+    }
+  };
+
+} // namespace wlw::rendering
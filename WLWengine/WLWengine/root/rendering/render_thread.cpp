@@ -0,0 +1,115 @@
+#include "render_thread.h"
+
+#include <future>
+
+namespace wlw::rendering {
+
+  RenderThread::RenderThread(RenderingDriver* driver, std::shared_ptr<scene::Window> context_window, FramePacer* frame_pacer)
+    : driver_(driver), context_window_(context_window), frame_pacer_(frame_pacer) {}
+
+  RenderThread::~RenderThread() {
+    Stop();
+  }
+
+  void RenderThread::Start() {
+    if (IsRunning()) {
+      return;
+    }
+    stopping_ = false;
+    thread_ = std::thread([this]() { Loop(); });
+  }
+
+  void RenderThread::Stop() {
+    if (!IsRunning()) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    condition_.notify_all();
+    thread_.join();
+
+    context_window_->MakeContextCurrent();
+  }
+
+  RenderThread::Frame& RenderThread::BeginFrame() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this]() { return pending_ == -1; });
+    writing_ = rendering_ == 0 ? 1 : 0;
+    return frames_[writing_];
+  }
+
+  void RenderThread::SubmitFrame() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_ = writing_;
+      writing_ = -1;
+    }
+    condition_.notify_all();
+  }
+
+  void RenderThread::Invoke(const std::function<void()>& task) {
+    if (!IsRunning() || IsRenderThread()) {
+      task();
+      return;
+    }
+
+    std::packaged_task<void()> packaged(task);
+    std::future<void> done = packaged.get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.emplace([&packaged]() { packaged(); });
+    }
+    condition_.notify_all();
+    done.get();
+  }
+
+  void RenderThread::Loop() {
+    context_window_->MakeContextCurrent();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      condition_.wait(lock, [this]() { return stopping_ || pending_ != -1 || !tasks_.empty(); });
+
+      while (!tasks_.empty()) {
+        auto task = std::move(tasks_.front());
+        tasks_.pop();
+        lock.unlock();
+        task();
+        lock.lock();
+      }
+
+      if (pending_ != -1) {
+        rendering_ = pending_;
+        pending_ = -1;
+        lock.unlock();
+        condition_.notify_all();
+
+        for (auto& window_frame : frames_[rendering_]) {
+          driver_->DrawSnapshot(window_frame.window, window_frame.snapshot);
+        }
+        for (auto& window_frame : frames_[rendering_]) {
+          driver_->Present(window_frame.window);
+        }
+        if (frame_pacer_) {
+          frame_pacer_->OnPresent();
+        }
+
+        lock.lock();
+        rendering_ = -1;
+        continue;
+      }
+
+      if (stopping_) {
+        break;
+      }
+    }
+    lock.unlock();
+
+    // Tasks submitted while stopping already ran above; hand the context back to whoever calls Stop().
+    // The last present may have left a secondary window's context current, so release whichever it is.
+    scene::Window::ReleaseCurrentContext();
+  }
+
+} // namespace wlw::rendering
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "rendering/frame_pacer.h"
+#include "rendering/render_device.h"
+#include "rendering/rendering_driver.h"
+#include "rendering/scene_snapshot.h"
+#include "scene/window.h"
+
+namespace wlw::rendering {
+
+  // Owns the graphics context and draws the snapshots the update thread hands over, one frame behind it.
+  // Two frame slots: the update thread extracts into one while the render thread draws the other, so
+  // a frame costs max(update, render) instead of their sum.
+  class RenderThread {
+  public:
+    struct WindowFrame {
+      std::shared_ptr<scene::Window> window;
+      SceneSnapshot snapshot;
+    };
+    using Frame = std::vector<WindowFrame>;
+
+    // `frame_pacer`, if any, is told about every presented frame.
+    RenderThread(RenderingDriver* driver, std::shared_ptr<scene::Window> context_window, FramePacer* frame_pacer = nullptr);
+    ~RenderThread();
+
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    // The calling thread must release the context first; Stop() hands it back to the caller.
+    void Start();
+    void Stop();
+
+    bool IsRunning() const { return thread_.joinable(); }
+    bool IsRenderThread() const { return std::this_thread::get_id() == thread_.get_id(); }
+
+    // Update thread only. Blocks while the previously submitted frame has not been picked up yet.
+    Frame& BeginFrame();
+    void SubmitFrame();
+
+    // Runs `task` on the render thread and waits for it; runs inline on the render thread or when stopped.
+    void Invoke(const std::function<void()>& task);
+
+  private:
+    void Loop();
+
+    RenderingDriver* driver_;
+    std::shared_ptr<scene::Window> context_window_;
+    FramePacer* frame_pacer_;
+    std::thread thread_;
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::array<Frame, 2> frames_;
+    int writing_ = -1;   // slot the update thread is filling
+    int pending_ = -1;   // submitted, not yet picked up
+    int rendering_ = -1; // slot the render thread is drawing
+    std::queue<std::function<void()>> tasks_;
+    bool stopping_ = false;
+  };
+
+  // Forwards resource creation to the render thread when called from any other thread while threaded
+  // rendering is on; otherwise it is a plain pass-through to the wrapped device.
+  class ThreadedRenderDevice : public RenderDevice {
+  public:
+    explicit ThreadedRenderDevice(RenderDevice* device) : device_(device) {}
+
+    void SetRenderThread(RenderThread* render_thread) {
+      render_thread_ = render_thread;
+    }
+
+    std::unique_ptr<core::WVertexBuffer> CreateVertexBuffer(const std::vector<core::Vertex2D>& vertices) override {
+      std::unique_ptr<core::WVertexBuffer> result;
+      Run([&]() { result = device_->CreateVertexBuffer(vertices); });
+      return result;
+    }
+
+    std::unique_ptr<core::WVertexBuffer> CreateVertexBuffer(const std::vector<core::Vertex3D>& vertices) override {
+      std::unique_ptr<core::WVertexBuffer> result;
+      Run([&]() { result = device_->CreateVertexBuffer(vertices); });
+      return result;
+    }
+
+    std::unique_ptr<core::WIndexBuffer> CreateIndexBuffer(const std::vector<uint32_t>& indices) override {
+      std::unique_ptr<core::WIndexBuffer> result;
+      Run([&]() { result = device_->CreateIndexBuffer(indices); });
+      return result;
+    }
+
+    std::shared_ptr<WTexture2D> CreateTexture2D(const utils::RawImage& data) override {
+      if (device_->SupportsConcurrentCreation()) {
+        return device_->CreateTexture2D(data);
+      }
+      std::shared_ptr<WTexture2D> result;
+      Run([&]() { result = device_->CreateTexture2D(data); });
+      return result;
+    }
+
+    std::shared_ptr<WCubemap> CreateCubemap(const std::array<utils::RawImage, 6>& faces) override {
+      if (device_->SupportsConcurrentCreation()) {
+        return device_->CreateCubemap(faces);
+      }
+      std::shared_ptr<WCubemap> result;
+      Run([&]() { result = device_->CreateCubemap(faces); });
+      return result;
+    }
+
+    void InitializeContextResources() override {
+      device_->InitializeContextResources();
+    }
+
+    bool SupportsConcurrentCreation() const override {
+      return device_->SupportsConcurrentCreation();
+    }
+
+    GeometryPool* GetGeometryPool() override {
+      return device_->GetGeometryPool();
+    }
+
+    void ReleasePendingResources() override {
+      Run([&]() { device_->ReleasePendingResources(); });
+    }
+
+  private:
+    void Run(const std::function<void()>& task) {
+      if (render_thread_ && render_thread_->IsRunning()) {
+        render_thread_->Invoke(task);
+      }
+      else {
+        task();
+      }
+    }
+
+    RenderDevice* device_;
+    RenderThread* render_thread_ = nullptr;
+  };
+
+} // namespace wlw::rendering
@@ -11,6 +11,9 @@
 #include "rendering/texture.h"
 
 #include "rendering/render_device.h"
+#include "rendering/scene_snapshot.h"
+#include "rendering/render_stats.h"
+#include "rendering/upload_queue.h"
 
 #include "scene/window.h"
 
@@ -21,11 +24,29 @@ public:
 
 	virtual bool Initialize(std::shared_ptr<scene::Window> window) = 0;
 	virtual void AttachWindow(std::shared_ptr<scene::Window> window) = 0;
+  // Single-threaded frame: window input, snapshot extraction and draw on the calling thread; Present() follows.
   virtual void DrawWindow(std::shared_ptr<scene::Window> window) = 0;
+  // Draws an extracted snapshot; must run on the thread that owns the context.
+  virtual void DrawSnapshot(std::shared_ptr<scene::Window> window, const SceneSnapshot& snapshot) = 0;
+  // Swaps the window's buffers. Drawing every window before presenting any lets only the last swap wait
+  // for vsync instead of each one.
+  virtual void Present(std::shared_ptr<scene::Window> window) = 0;
 
   virtual void SetViewport(int x, int y, int width, int height) = 0;
   virtual void Clear() = 0;
 
+  // Optional depth-only pass before shading; trades extra vertex work for zero overdraw shading.
+  virtual void SetDepthPrePassEnabled(bool enabled) = 0;
+  virtual bool IsDepthPrePassEnabled() const = 0;
+
+  // Caps the geometry moved into the geometry pool per frame; meshes over budget are skipped until their turn.
+  virtual void SetUploadBudget(const UploadBudget& budget) = 0;
+
+  // Safe to call from any thread. GPU timings trail the submitted frame by a few frames.
+  virtual RenderStats GetStats() const = 0;
+  // Periodically prints averaged per-pass GPU timings to stdout.
+  virtual void SetGpuTimingLogEnabled(bool enabled) = 0;
+
   virtual RenderDevice* GetDevice() = 0;
 
 	static std::unique_ptr<RenderingDriver> Create(RenderDevice* device);
@@ -1,53 +1,130 @@
 #ifdef WLW_USE_GLFW
 
 #include <glad/glad.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
 #include <iostream>
+#include <mutex>
+#include <vector>
 #include <GLFW/glfw3.h>
 
 #include "shaders/basic_shaders.h"
 #include "shaders/skybox_shaders.h"
+#include "shaders/depth_shaders.h"
 
 #include "core/logger.h"
+#include "core/packed_vertex_3d.h"
 #include "rendering_driver.h"
 #include "rendering/render_device.h"
 #include "rendering/gl_index_buffer.h"
 #include "rendering/gl_vertex_buffer.h"
+#include "rendering/render_queue.h"
+#include "rendering/command_list.h"
+#include "rendering/gl_program_cache.h"
+#include "rendering/shader_variant.h"
+#include "rendering/light_clusters.h"
+#include "rendering/gl_context_vertex_array.h"
+#include "rendering/gl_gpu_timer.h"
+#include "utils/thread_pool.h"
 
 namespace wlw::rendering {
 
   void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
+    // Events are polled on the update thread, which has no context when rendering is threaded.
+    if (glfwGetCurrentContext() == window) {
+      glViewport(0, 0, width, height);
+    }
   }
 
   void error_callback(int error, const char* description) {
 		std::cerr << "GLFW Error " << error << ": " << description << std::endl;
   }
 
+  namespace {
+
+    // Diffuse + Blinn-Phong specular term of the 3D fragment shader's Shade(), for one light.
+    float ShadeTerm(const glm::vec3& normal, const glm::vec3& light_dir, const glm::vec3& view_dir, float shininess) {
+      float diff = std::max(glm::dot(normal, light_dir), 0.0f);
+      float spec = diff > 0.0f ? std::pow(std::max(glm::dot(normal, glm::normalize(light_dir + view_dir)), 0.0f), shininess) : 0.0f;
+      return diff + spec;
+    }
+
+    // A cube drawn from packed vertices must light exactly like the same cube drawn from Vertex3D: decodes
+    // each face normal the way the packed vertex stage does and compares the shading from a few directions.
+    bool PackedCubeShadesLikeUnpacked() {
+      const glm::vec3 face_normals[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+      std::vector<core::Vertex3D> cube;
+      for (const auto& n : face_normals) {
+        cube.push_back({ { n.x * 0.5f, n.y * 0.5f, n.z * 0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f }, { n.x, n.y, n.z }, { 0.0f, 0.0f } });
+      }
+      core::PackedVertices3D packed = core::PackVertices(cube);
+
+      const glm::vec3 light_dirs[3] = { glm::normalize(glm::vec3(0.3f, 1.0f, 0.5f)), glm::normalize(glm::vec3(-1.0f, -0.2f, 0.4f)), glm::normalize(glm::vec3(0.0f, 0.1f, -1.0f)) };
+      const glm::vec3 view_dir = glm::normalize(glm::vec3(0.2f, 0.4f, 1.0f));
+      for (size_t i = 0; i < cube.size(); ++i) {
+        core::Vector3 decoded = core::DecodeOctahedralNormal(packed.vertices[i].normal);
+        glm::vec3 packed_normal(decoded.x, decoded.y, decoded.z);
+        glm::vec3 normal(cube[i].normal.x, cube[i].normal.y, cube[i].normal.z);
+        for (const auto& light_dir : light_dirs) {
+          if (std::abs(ShadeTerm(packed_normal, light_dir, view_dir, 32.0f) - ShadeTerm(normal, light_dir, view_dir, 32.0f)) > 1e-3f) {
+            return false;
+          }
+        }
+      }
+      return true;
+    }
+
+    // Type of an active vertex attribute, or 0 if the program does not use it.
+    GLenum GetAttributeType(GLuint program, const char* name) {
+      GLint count = 0;
+      glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+      for (GLint i = 0; i < count; ++i) {
+        char attribute[64];
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveAttrib(program, (GLuint)i, sizeof(attribute), nullptr, &size, &type, attribute);
+        if (std::strcmp(attribute, name) == 0) {
+          return type;
+        }
+      }
+      return 0;
+    }
+
+  } // namespace
+
 
 class GLRenderingDriver : public RenderingDriver {
 public:
-    struct UniformLocations {
+    // Locations in one 3D color variant; uniforms the variant compiled out resolve to -1 (ignored by GL).
+    struct ColorUniforms {
         GLint model;
+        GLint normalMatrix;
         GLint view;
         GLint projection;
         GLint viewPos;
-        GLint lightType;
-        GLint lightPos;
-        GLint lightDir;
-        GLint lightColor;
-        GLint useLighting;
-        GLint ambientStrength;
         GLint shininess;
-        GLint lightConstant;
-        GLint lightLinear;
-        GLint lightQuadratic;
-        GLint lightCutOff;
-        GLint lightOuterCutOff;
-        GLint use_texture;
-        GLint model_texture;
-        
-        GLint skyboxView;
-        GLint skyboxProj;
+        GLint baseColor;
+        GLint directionalLightCount;
+        GLint directionalLights;
+        GLint clusterDims;
+        GLint clusterTileSize;
+        GLint clusterSliceScaleBias;
+    };
+
+    struct ShaderVariant {
+        GLuint program = 0;
+        bool failed = false;
+        ColorUniforms uniforms{};
+    };
+
+    struct UniformLocations {
+        GLint skyboxInvViewProj;
+
+        GLint depthModel;
+        GLint depthView;
+        GLint depthProj;
     } m_Uniforms;
 
     GLRenderingDriver(RenderDevice* device) : device_(device) {}
@@ -73,7 +150,7 @@ public:
 #endif
     window->Initialize();
 		window->MakeContextCurrent();
-		window->ProcessEvents();
+		scene::Window::PollEvents();
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
     {
@@ -88,62 +165,53 @@ public:
     std::cout << "Version: " << glGetString(GL_VERSION) << std::endl;
     std::cout << "-----------------------------------" << std::endl;
 
-    m_ShaderID_2D = CreateProgram(vertex2DShaderSource, fragment2DShaderSource);
+    device_->InitializeContextResources();
+    program_cache_.Initialize();
+
+    m_ShaderID_2D = program_cache_.GetProgram(vertex2DShaderSource, fragment2DShaderSource);
     if (m_ShaderID_2D == 0) return false;
 
-    m_ShaderID_3D = CreateProgram(vertex3DShaderSource, fragment3DShaderSource);
-    if (m_ShaderID_3D == 0) return false;
+#ifndef NDEBUG
+    FAIL_IF(!PackedCubeShadesLikeUnpacked(), "packed vertex normals no longer decode to the shading of unpacked ones");
+#endif
+
+    // Other 3D variants are compiled the first time a draw needs them.
+    if (EnsureShaderVariant(0) == nullptr) return false;
 
-    m_ShaderID_Skybox = CreateProgram(skyboxVertexShaderSource, skyboxFragmentShaderSource);
+    m_ShaderID_Skybox = program_cache_.GetProgram(skyboxVertexShaderSource, skyboxFragmentShaderSource);
     if (m_ShaderID_Skybox == 0) return false;
 
+    m_ShaderID_Depth = program_cache_.GetProgram(depthVertexShaderSource, depthFragmentShaderSource);
+    if (m_ShaderID_Depth == 0) return false;
+
+    const auto& cache_stats = program_cache_.GetStats();
+    std::cout << "Shader programs ready in " << cache_stats.milliseconds << " ms ("
+              << cache_stats.loaded << " from binary cache, " << cache_stats.compiled << " compiled"
+              << (program_cache_.IsBinarySupported() ? "" : ", program binaries unsupported") << ")" << std::endl;
+
     glUseProgram(m_ShaderID_Skybox);
     glUniform1i(glGetUniformLocation(m_ShaderID_Skybox, "skybox"), 0);
     glUseProgram(0);
 
-    m_Uniforms.model = glGetUniformLocation(m_ShaderID_3D, "model");
-    m_Uniforms.view = glGetUniformLocation(m_ShaderID_3D, "view");
-    m_Uniforms.projection = glGetUniformLocation(m_ShaderID_3D, "projection");
-    m_Uniforms.viewPos = glGetUniformLocation(m_ShaderID_3D, "viewPos");
-    m_Uniforms.lightType = glGetUniformLocation(m_ShaderID_3D, "lightType");
-    m_Uniforms.lightPos = glGetUniformLocation(m_ShaderID_3D, "lightPos");
-    m_Uniforms.lightDir = glGetUniformLocation(m_ShaderID_3D, "lightDir");
-    m_Uniforms.lightColor = glGetUniformLocation(m_ShaderID_3D, "lightColor");
-    m_Uniforms.useLighting = glGetUniformLocation(m_ShaderID_3D, "useLighting");
-    m_Uniforms.ambientStrength = glGetUniformLocation(m_ShaderID_3D, "ambientStrength");
-    m_Uniforms.shininess = glGetUniformLocation(m_ShaderID_3D, "shininess");
-    m_Uniforms.lightConstant = glGetUniformLocation(m_ShaderID_3D, "lightConstant");
-    m_Uniforms.lightLinear = glGetUniformLocation(m_ShaderID_3D, "lightLinear");
-    m_Uniforms.lightQuadratic = glGetUniformLocation(m_ShaderID_3D, "lightQuadratic");
-    m_Uniforms.lightCutOff = glGetUniformLocation(m_ShaderID_3D, "lightCutOff");
-    m_Uniforms.lightOuterCutOff = glGetUniformLocation(m_ShaderID_3D, "lightOuterCutOff");
-    m_Uniforms.use_texture = glGetUniformLocation(m_ShaderID_3D, "use_texture");
-    m_Uniforms.model_texture = glGetUniformLocation(m_ShaderID_3D, "model_texture");
-
-    m_Uniforms.skyboxView = glGetUniformLocation(m_ShaderID_Skybox, "view");
-    m_Uniforms.skyboxProj = glGetUniformLocation(m_ShaderID_Skybox, "projection");
-
-    float skyboxVertices[] = {
-        -1.0f,  1.0f, -1.0f, -1.0f, -1.0f, -1.0f,  1.0f, -1.0f, -1.0f,
-         1.0f, -1.0f, -1.0f,  1.0f,  1.0f, -1.0f, -1.0f,  1.0f, -1.0f,
-        -1.0f, -1.0f,  1.0f, -1.0f, -1.0f, -1.0f, -1.0f,  1.0f, -1.0f,
-        -1.0f,  1.0f, -1.0f, -1.0f,  1.0f,  1.0f, -1.0f, -1.0f,  1.0f,
-         1.0f, -1.0f, -1.0f,  1.0f, -1.0f,  1.0f,  1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,  1.0f,  1.0f, -1.0f,  1.0f, -1.0f, -1.0f,
-        -1.0f, -1.0f,  1.0f, -1.0f,  1.0f,  1.0f,  1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,  1.0f, -1.0f,  1.0f, -1.0f, -1.0f,  1.0f,
-        -1.0f,  1.0f, -1.0f,  1.0f,  1.0f, -1.0f,  1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f, -1.0f,  1.0f,  1.0f, -1.0f,  1.0f, -1.0f,
-        -1.0f, -1.0f, -1.0f, -1.0f, -1.0f,  1.0f,  1.0f, -1.0f, -1.0f,
-         1.0f, -1.0f, -1.0f, -1.0f, -1.0f,  1.0f,  1.0f, -1.0f,  1.0f
-    };
-    glGenVertexArrays(1, &m_SkyboxVAO);
-    glGenBuffers(1, &m_SkyboxVBO);
-    glBindVertexArray(m_SkyboxVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_SkyboxVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    m_Uniforms.skyboxInvViewProj = glGetUniformLocation(m_ShaderID_Skybox, "inverseViewProjection");
+
+    m_Uniforms.depthModel = glGetUniformLocation(m_ShaderID_Depth, "model");
+    m_Uniforms.depthView = glGetUniformLocation(m_ShaderID_Depth, "view");
+    m_Uniforms.depthProj = glGetUniformLocation(m_ShaderID_Depth, "projection");
+
+    gpu_timer_.Initialize();
+
+    // Light data (RGBA32F), cluster records (RG32UI) and light index lists (R32UI) for clustered shading.
+    static const GLenum kLightBufferFormats[kLightBufferCount] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+    glGenBuffers((GLsizei)kLightBufferCount, m_LightBuffers);
+    glGenTextures((GLsizei)kLightBufferCount, m_LightTextures);
+    for (size_t i = 0; i < kLightBufferCount; ++i) {
+      UploadLightBuffer(i, nullptr, 0);
+      glBindTexture(GL_TEXTURE_BUFFER, m_LightTextures[i]);
+      glTexBuffer(GL_TEXTURE_BUFFER, kLightBufferFormats[i], m_LightBuffers[i]);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
 
     glEnable(GL_DEPTH_TEST);
     return true;
@@ -167,183 +235,592 @@ public:
   }
 
   void DrawWindow(std::shared_ptr<scene::Window> window) override {
-    window->MakeContextCurrent();
     window->ProcessEvents();
+    ExtractSceneSnapshot(*window, snapshot_);
+    DrawSnapshot(window, snapshot_);
+  }
 
-    auto size = window->GetSize();
+  void DrawSnapshot(std::shared_ptr<scene::Window> window, const SceneSnapshot& snapshot) override {
+    window->MakeContextCurrent();
+    // Capabilities are per context and windows attached later start from defaults.
+    glEnable(GL_DEPTH_TEST);
+    device_->ReleasePendingResources();
+    frame_depth_prepass_ = depth_prepass_enabled_;
+
+    // Query objects belong to one context, so only the main window is timed.
+    frame_timed_ = window == main_window_;
+    RenderStats resolved;
+    if (frame_timed_ && gpu_timer_.BeginFrame(resolved)) {
+      PublishStats(resolved);
+    }
 
-    SetViewport(0, 0, (int)size.x, (int)size.y);
+    SetViewport(0, 0, (int)snapshot.viewport_size.x, (int)snapshot.viewport_size.y);
     Clear();
 
-    auto camera = window->GetUpdatedCamera();
-    glm::mat4 view = camera->GetViewMatrix();
-    glm::mat4 proj = camera->GetProjectionMatrix();
-
-    // --- RENDER SKYBOX FIRST ---
-    auto skybox = window->GetSkybox();
-    if (skybox) {
-        glDisable(GL_DEPTH_TEST);
-        glDepthMask(GL_FALSE);
-        glDisable(GL_CULL_FACE);
-        
-        glUseProgram(m_ShaderID_Skybox);
-        
-        glm::mat4 staticView = glm::mat4(glm::mat3(view));
-        glUniformMatrix4fv(glGetUniformLocation(m_ShaderID_Skybox, "view"), 1, GL_FALSE, glm::value_ptr(staticView));
-        glUniformMatrix4fv(glGetUniformLocation(m_ShaderID_Skybox, "projection"), 1, GL_FALSE, glm::value_ptr(proj));
-        
-        glBindVertexArray(m_SkyboxVAO);
-        skybox->Bind(0);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-        
-        glDepthMask(GL_TRUE);
-        glEnable(GL_DEPTH_TEST);
-    }
-
-    glUseProgram(m_ShaderID_3D);
-    glUniformMatrix4fv(m_Uniforms.view, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(m_Uniforms.projection, 1, GL_FALSE, glm::value_ptr(proj));
-    core::Vector3 camPos = camera->GetPosition();
-    glUniform3f(m_Uniforms.viewPos, camPos.x, camPos.y, camPos.z);
-
-    scene::Frustum frustum = scene::Frustum::FromMatrix(proj * view);
-
-    window->IterateOver3DNodes([this, window, &frustum](const std::shared_ptr<scene::Node3D> node) {
-
-      if (!frustum.TestAABB(node->GetAABB())) {
-          return;
+    UploadGeometry(snapshot);
+    BuildRenderQueue(snapshot);
+    UploadLighting(snapshot);
+    RecordCommandLists(snapshot.view, snapshot.projection, snapshot.camera_position);
+
+    if (frame_depth_prepass_) {
+      BeginTimedPass(RenderPass::DepthPrePass);
+      glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+      for (const auto& list : depth_lists_) {
+        ExecuteCommandList(list);
       }
+      glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+      EndTimedPass();
+
+      // Every visible surface already has its final depth: shade only the fragments that match it.
+      glDepthFunc(GL_LEQUAL);
+      glDepthMask(GL_FALSE);
+    }
 
-      auto model = node->GetModel();
+    BeginTimedPass(RenderPass::Opaque);
+    for (const auto& list : color_lists_) {
+      ExecuteCommandList(list);
+    }
+    EndTimedPass();
+
+    device_->GetGeometryPool()->Unbind();
+    // Everything drawn outside the command lists (the skybox) expects both sides.
+    SetCullMode(CullMode::None);
+
+    if (frame_depth_prepass_) {
+      glDepthMask(GL_TRUE);
+      glDepthFunc(GL_LESS);
+    }
+
+    // --- RENDER SKYBOX LAST --- so early-z rejects every pixel opaque geometry already covered.
+    if (snapshot.skybox && snapshot.skybox->IsReady()) {
+      BeginTimedPass(RenderPass::Skybox);
+      DrawSkybox(snapshot.skybox, snapshot.view, snapshot.projection);
+      EndTimedPass();
+    }
+
+    // The queue points into the snapshot, which the update thread is about to refill.
+    render_queue_.Clear();
+  }
+
+  void Present(std::shared_ptr<scene::Window> window) override {
+    window->MakeContextCurrent();
+    window->SwapBuffers();
+  }
+
+  void BeginTimedPass(RenderPass pass) {
+    if (frame_timed_) {
+      gpu_timer_.BeginPass(pass);
+    }
+  }
+
+  void EndTimedPass() {
+    if (frame_timed_) {
+      gpu_timer_.EndPass();
+    }
+  }
+
+  void DrawSkybox(const std::shared_ptr<WCubemap>& skybox, const glm::mat4& view, const glm::mat4& proj) {
+    // The fullscreen triangle sits at depth 1.0, which only passes LEQUAL where nothing was drawn.
+    glDepthFunc(GL_LEQUAL);
+    glDepthMask(GL_FALSE);
+
+    glUseProgram(m_ShaderID_Skybox);
+
+    glm::mat4 staticView = glm::mat4(glm::mat3(view));
+    glm::mat4 inverseViewProj = glm::inverse(proj * staticView);
+    glUniformMatrix4fv(m_Uniforms.skyboxInvViewProj, 1, GL_FALSE, glm::value_ptr(inverseViewProj));
+
+    m_SkyboxVAO.Bind();
+    skybox->Bind(0);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+  }
+
+  RenderStats GetStats() const override {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
+  }
+
+  void SetUploadBudget(const UploadBudget& budget) override {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    upload_budget_ = budget;
+  }
+
+  void SetGpuTimingLogEnabled(bool enabled) override {
+    log_gpu_timings_ = enabled;
+  }
+
+  void PublishStats(const RenderStats& resolved) {
+    {
+      // Only the GPU timings; the other counters are published as they are produced.
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      stats_.gpu_milliseconds = resolved.gpu_milliseconds;
+      stats_.gpu_total_milliseconds = resolved.gpu_total_milliseconds;
+      stats_.gpu_frame = resolved.gpu_frame;
+      stats_.gpu_timers_available = resolved.gpu_timers_available;
+    }
+
+    if (!log_gpu_timings_) {
+      logged_frames_ = 0;
+      return;
+    }
+
+    static constexpr uint32_t kLogInterval = 120;
+    for (size_t pass = 0; pass < logged_milliseconds_.size(); ++pass) {
+      logged_milliseconds_[pass] += resolved.gpu_milliseconds[pass];
+    }
+    if (++logged_frames_ < kLogInterval) {
+      return;
+    }
 
-      if (model == nullptr || model->meshes.empty()) {
-        return;
+    std::cout << "GPU ms (avg of " << kLogInterval << " frames):";
+    float total = 0.0f;
+    for (size_t pass = 0; pass < logged_milliseconds_.size(); ++pass) {
+      float average = logged_milliseconds_[pass] / kLogInterval;
+      total += average;
+      std::cout << " " << GetRenderPassName((RenderPass)pass) << " " << average;
+      logged_milliseconds_[pass] = 0.0f;
+    }
+    std::cout << " | total " << total << std::endl;
+    logged_frames_ = 0;
+  }
+
+  void SetDepthPrePassEnabled(bool enabled) override {
+    depth_prepass_enabled_ = enabled;
+  }
+
+  bool IsDepthPrePassEnabled() const override {
+    return depth_prepass_enabled_;
+  }
+
+  // Queues visible meshes that are not in the geometry pool yet and moves a budget's worth of the queue in.
+  void UploadGeometry(const SceneSnapshot& snapshot) {
+    for (const auto& proxy : snapshot.proxies) {
+      if (!proxy.mesh->GetGeometry()) {
+        upload_queue_.Request(proxy.mesh);
       }
+    }
 
-      glUniformMatrix4fv(m_Uniforms.model, 1, GL_FALSE, glm::value_ptr(node->GetModelMatrix()));
+    UploadBudget budget;
+    {
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      budget = upload_budget_;
+    }
+    size_t uploaded = upload_queue_.Drain(device_->GetGeometryPool(), budget);
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.pending_uploads = (uint32_t)upload_queue_.GetPendingCount();
+    stats_.pending_upload_bytes = upload_queue_.GetPendingBytes();
+    stats_.uploaded_bytes = uploaded;
+
+    core::MeshMemoryStats mesh_memory = core::GetMeshMemoryStats();
+    GeometryPoolStats pool_stats = device_->GetGeometryPool()->GetStats();
+    stats_.mesh_cpu_bytes = mesh_memory.cpu_bytes;
+    stats_.mesh_released_bytes = mesh_memory.released_bytes;
+    stats_.geometry_gpu_bytes = pool_stats.vertex_bytes_used + pool_stats.index_bytes_used;
+  }
 
-      for (const auto& mesh : model->meshes) {
-        auto node_mat = node->GetMaterial();
-        auto mesh_mat = mesh->GetMaterial();
-        
-        bool has_lighting = (node_mat && node_mat->GetLighting().has_value()) || 
-                            (mesh_mat && mesh_mat->GetLighting().has_value());
+  // Queues the snapshot's resident proxies by shader variant and front to back; the rest wait for the upload stage.
+  void BuildRenderQueue(const SceneSnapshot& snapshot) {
+    render_queue_.Clear();
+
+    for (const auto& proxy : snapshot.proxies) {
+      const GeometryAllocation* geometry = proxy.mesh->GetGeometry();
+      const IndexRange* index_ranges = proxy.index_range_count > 0 ? &snapshot.index_ranges[proxy.first_index_range] : nullptr;
+      uint32_t index_range_count = proxy.index_range_count;
+      if ((!geometry || !geometry->IsReady()) && proxy.fallback_mesh) {
+        // The selected LOD is still uploading: draw the full mesh, unculled, in the meantime.
+        geometry = proxy.fallback_mesh->GetGeometry();
+        index_ranges = nullptr;
+        index_range_count = 0;
+      }
+      if (!geometry || !geometry->IsReady()) {
+        continue;
+      }
 
-        glUniform1i(m_Uniforms.use_texture, false);
-        glUniform1i(m_Uniforms.useLighting, has_lighting);
+      uint32_t variant = GetShaderVariant(proxy);
+      if ((variant & ShaderFeatureTexture) && !proxy.texture->IsReady()) {
+        // Still uploading: shade with vertex colors until the pixels arrive.
+        variant &= ~ShaderFeatureTexture;
+      }
+      if (geometry->GetRange().layout == VertexLayout::Packed3D) {
+        variant |= ShaderFeaturePackedVertex;
+      }
+      if (EnsureShaderVariant(variant) == nullptr) {
+        continue;
+      }
+      CullMode cull_mode = proxy.double_sided ? CullMode::None : proxy.mirrored ? CullMode::BackMirrored : CullMode::Back;
+      render_queue_.Push({ &proxy, geometry, variant, proxy.view_depth, index_ranges, index_range_count, cull_mode });
+    }
 
-        if (node_mat) {
-          BindMaterial(node_mat);
-        }
-        if (mesh_mat) {
-          BindMaterial(mesh_mat);
-        }
+    render_queue_.Sort();
 
-        if (!mesh->GetVertexBuffer()) {
-            mesh->SetVertexBuffer(device_->CreateVertexBuffer(mesh->GetVertices()));
-        }
-        if (!mesh->GetIndexBuffer()) {
-            mesh->SetIndexBuffer(device_->CreateIndexBuffer(mesh->GetIndices()));
-        }
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.visible_meshlets = snapshot.visible_meshlets;
+    stats_.culled_meshlets = snapshot.culled_meshlets;
+  }
+
+  // Compiles (or restores from the program cache) the 3D program specialized for `key`. Render thread only.
+  const ShaderVariant* EnsureShaderVariant(uint32_t key) {
+    ShaderVariant& variant = m_ShaderVariants[key];
+    if (variant.program != 0 || variant.failed) {
+      return variant.failed ? nullptr : &variant;
+    }
+
+    // Both stages are specialized: the vertex stage decodes packed vertices, the fragment stage picks its features.
+    std::string defines = GetShaderDefines(key);
+    std::string vertex_source = InjectShaderDefines(vertex3DShaderSource, defines);
+    std::string fragment_source = InjectShaderDefines(fragment3DShaderSource, defines);
+    variant.program = program_cache_.GetProgram(vertex_source, fragment_source);
+    if (variant.program == 0) {
+      std::cerr << "3D shader variant " << key << " is unavailable, its draws are skipped" << std::endl;
+      variant.failed = true;
+      return nullptr;
+    }
+
+    GLuint program = variant.program;
+    // Packed geometry feeds two-component octahedral normals; a stage expecting three would misread them.
+    GLenum normal_type = GetAttributeType(program, "aNormal");
+    GLenum expected_normal_type = (key & ShaderFeaturePackedVertex) ? GL_FLOAT_VEC2 : GL_FLOAT_VEC3;
+    if (FAIL_IF(normal_type != 0 && normal_type != expected_normal_type, "3D shader variant " << key << " does not match its vertex layout")) {
+      glDeleteProgram(program);
+      variant.program = 0;
+      variant.failed = true;
+      return nullptr;
+    }
+
+    ColorUniforms& uniforms = variant.uniforms;
+    uniforms.model = glGetUniformLocation(program, "model");
+    uniforms.normalMatrix = glGetUniformLocation(program, "normalMatrix");
+    uniforms.view = glGetUniformLocation(program, "view");
+    uniforms.projection = glGetUniformLocation(program, "projection");
+    uniforms.viewPos = glGetUniformLocation(program, "viewPos");
+    uniforms.shininess = glGetUniformLocation(program, "shininess");
+    uniforms.baseColor = glGetUniformLocation(program, "baseColor");
+    uniforms.directionalLightCount = glGetUniformLocation(program, "directionalLightCount");
+    uniforms.directionalLights = glGetUniformLocation(program, "directionalLights");
+    uniforms.clusterDims = glGetUniformLocation(program, "clusterDims");
+    uniforms.clusterTileSize = glGetUniformLocation(program, "clusterTileSize");
+    uniforms.clusterSliceScaleBias = glGetUniformLocation(program, "clusterSliceScaleBias");
+
+    // The material texture always lives in unit 0, the light cluster buffers in the units after it.
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "model_texture"), 0);
+    for (GLint i = 0; i < (GLint)kLightBufferCount; ++i) {
+      glUniform1i(glGetUniformLocation(program, kLightBufferSamplers[i]), kLightBufferFirstUnit + i);
+    }
+    glUseProgram(0);
+    return &variant;
+  }
 
-        const auto* vertex_buffer = mesh->GetVertexBuffer();
-        const auto* index_buffer = mesh->GetIndexBuffer();
+  // Splits the sorted queue into contiguous buckets and records each one on a worker thread.
+  // Buckets are replayed in order, so the front-to-back ordering survives the split.
+  void RecordCommandLists(const glm::mat4& view, const glm::mat4& proj, const glm::vec3& view_pos) {
+    static constexpr size_t kMinItemsPerBucket = 64;
 
-        vertex_buffer->Bind();
-        index_buffer->Bind();
+    auto& pool = utils::ThreadPool::GetInstance();
+    size_t item_count = render_queue_.GetItems().size();
+    size_t bucket_count = std::min(pool.GetWorkerCount() + 1, (item_count + kMinItemsPerBucket - 1) / kMinItemsPerBucket);
+    bucket_count = std::max<size_t>(bucket_count, 1);
 
-        DrawIndexed(static_cast<uint32_t>(mesh->GetIndices().size()));
+    color_lists_.resize(bucket_count);
+    depth_lists_.resize(frame_depth_prepass_ ? bucket_count : 0);
+    for (auto& list : color_lists_) list.Reset();
+    for (auto& list : depth_lists_) list.Reset();
 
-        vertex_buffer->Unbind();
-        index_buffer->Unbind();
+    pool.ParallelFor(item_count, bucket_count, [&](size_t bucket, size_t begin, size_t end) {
+      if (frame_depth_prepass_) {
+        RecordDepthPass(depth_lists_[bucket], begin, end, view, proj);
       }
+      RecordColorPass(color_lists_[bucket], begin, end, view, proj, view_pos);
     });
   }
 
-  void BindMaterial(std::shared_ptr<rendering::Material> material) {
-    if (!material) return;
+  void RecordDepthPass(CommandList& list, size_t begin, size_t end, const glm::mat4& view, const glm::mat4& proj) const {
+    const auto& items = render_queue_.GetItems();
+
+    list.BindProgram(m_ShaderID_Depth);
+    list.SetUniform(m_Uniforms.depthView, view);
+    list.SetUniform(m_Uniforms.depthProj, proj);
+
+    uint32_t last_object = 0;
+    const GeometryAllocation* last_quantized = nullptr;
+    const GeometryRange* last_range = nullptr;
+    CullMode last_cull_mode = CullMode::None;
+    for (size_t i = begin; i < end; ++i) {
+      const RenderProxy& proxy = *items[i].proxy;
+      const GeometryAllocation* geometry = items[i].geometry;
+      const GeometryAllocation* quantized = geometry->HasPositionTransform() ? geometry : nullptr;
+      if (proxy.object_id != last_object || quantized != last_quantized) {
+        list.SetUniform(m_Uniforms.depthModel, geometry->ApplyPositionTransform(proxy.model));
+        last_object = proxy.object_id;
+        last_quantized = quantized;
+      }
+      RecordDraw(list, items[i], geometry->GetRange(), last_range, last_cull_mode);
+    }
+  }
+
+  void RecordColorPass(CommandList& list, size_t begin, size_t end, const glm::mat4& view, const glm::mat4& proj, const glm::vec3& view_pos) const {
+    const auto& items = render_queue_.GetItems();
+
+    uint32_t last_variant = kShaderVariantCount;
+    const ColorUniforms* uniforms = nullptr;
+    uint32_t last_object = 0;
+    const GeometryAllocation* last_quantized = nullptr;
+    const GeometryRange* last_range = nullptr;
+    CullMode last_cull_mode = CullMode::None;
+    for (size_t i = begin; i < end; ++i) {
+      const RenderItem& item = items[i];
+      const RenderProxy& proxy = *item.proxy;
+      const GeometryAllocation* geometry = item.geometry;
+      // Quantized meshes fold their own dequantization into the model matrix, so it changes per mesh.
+      const GeometryAllocation* quantized = geometry->HasPositionTransform() ? geometry : nullptr;
+
+      // Uniforms are per program, so frame constants and the transform are re-sent after every switch.
+      if (item.shader_variant != last_variant) {
+        const ShaderVariant& variant = m_ShaderVariants[item.shader_variant];
+        uniforms = &variant.uniforms;
+        list.BindProgram(variant.program);
+        list.SetUniform(uniforms->view, view);
+        list.SetUniform(uniforms->projection, proj);
+        list.SetUniform(uniforms->viewPos, view_pos);
+        last_variant = item.shader_variant;
+        last_object = 0;
+      }
 
-    if (material->HasTexture()) {
-      glUniform1i(m_Uniforms.use_texture, true);
-      glActiveTexture(GL_TEXTURE0);
-      material->BindTexture();
-      glUniform1i(m_Uniforms.model_texture, 0); 
+      if (proxy.object_id != last_object || quantized != last_quantized) {
+        list.SetUniform(uniforms->model, geometry->ApplyPositionTransform(proxy.model));
+        list.SetUniform(uniforms->normalMatrix, proxy.normal_matrix);
+        last_object = proxy.object_id;
+        last_quantized = quantized;
+      }
+
+      RecordMaterial(list, *uniforms, item);
+      RecordDraw(list, item, geometry->GetRange(), last_range, last_cull_mode);
     }
+  }
 
-    if (const auto& lighting = material->GetLighting()) {
-      glUniform1i(m_Uniforms.useLighting, true);
-      glUniform1i(m_Uniforms.lightType, static_cast<int>(lighting->type));
-      glUniform3f(m_Uniforms.lightPos, lighting->position.x, lighting->position.y, lighting->position.z);
-      glUniform3f(m_Uniforms.lightDir, lighting->direction.x, lighting->direction.y, lighting->direction.z);
-      glUniform3f(m_Uniforms.lightColor, lighting->color.r, lighting->color.g, lighting->color.b);
-      glUniform1f(m_Uniforms.ambientStrength, lighting->ambient_strength);
-      glUniform1f(m_Uniforms.shininess, lighting->shininess);
-      glUniform1f(m_Uniforms.lightConstant, lighting->constant);
-      glUniform1f(m_Uniforms.lightLinear, lighting->linear);
-      glUniform1f(m_Uniforms.lightQuadratic, lighting->quadratic);
-      glUniform1f(m_Uniforms.lightCutOff, lighting->cutOff);
-      glUniform1f(m_Uniforms.lightOuterCutOff, lighting->outerCutOff);
+  void RecordMaterial(CommandList& list, const ColorUniforms& uniforms, const RenderItem& item) const {
+    const RenderProxy& proxy = *item.proxy;
+    if (item.shader_variant & ShaderFeatureTexture) {
+      list.BindTexture(0, proxy.texture.get());
     }
+    if (proxy.lit) {
+      list.SetUniform(uniforms.shininess, proxy.shininess);
+    }
+    list.SetUniform(uniforms.baseColor, proxy.base_color);
   }
 
-  void DrawIndexed(uint32_t indexCount) {
-    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr);
+  // Builds the light clusters for this view, streams them into the buffer textures and sets the per-frame
+  // lighting uniforms of every lit variant compiled so far.
+  void UploadLighting(const SceneSnapshot& snapshot) {
+    light_grid_.Build(snapshot.lights, snapshot.view, snapshot.projection, snapshot.viewport_size);
+
+    const auto& light_data = light_grid_.GetLightData();
+    const auto& clusters = light_grid_.GetClusters();
+    const auto& indices = light_grid_.GetLightIndices();
+    UploadLightBuffer(0, light_data.data(), light_data.size() * sizeof(glm::vec4));
+    UploadLightBuffer(1, clusters.data(), clusters.size() * sizeof(uint32_t));
+    UploadLightBuffer(2, indices.data(), indices.size() * sizeof(uint32_t));
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    for (GLint i = 0; i < (GLint)kLightBufferCount; ++i) {
+      glActiveTexture(GL_TEXTURE0 + kLightBufferFirstUnit + i);
+      glBindTexture(GL_TEXTURE_BUFFER, m_LightTextures[i]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    const auto& directional = light_grid_.GetDirectionalLights();
+    glm::vec2 tile_size = light_grid_.GetTileSize();
+    glm::vec2 slice_scale_bias = light_grid_.GetSliceScaleBias();
+    for (uint32_t key = 0; key < kShaderVariantCount; ++key) {
+      const ShaderVariant& variant = m_ShaderVariants[key];
+      if (!(key & ShaderFeatureLighting) || variant.program == 0) {
+        continue;
+      }
+      const ColorUniforms& uniforms = variant.uniforms;
+      glUseProgram(variant.program);
+      glUniform1i(uniforms.directionalLightCount, (GLint)light_grid_.GetDirectionalLightCount());
+      if (!directional.empty()) {
+        glUniform4fv(uniforms.directionalLights, (GLsizei)directional.size(), glm::value_ptr(directional[0]));
+      }
+      glUniform3i(uniforms.clusterDims, LightClusterGrid::kTilesX, LightClusterGrid::kTilesY, LightClusterGrid::kSlicesZ);
+      glUniform2f(uniforms.clusterTileSize, tile_size.x, tile_size.y);
+      glUniform2f(uniforms.clusterSliceScaleBias, slice_scale_bias.x, slice_scale_bias.y);
+    }
+    glUseProgram(0);
   }
 
-  ~GLRenderingDriver() override {
-    glDeleteProgram(m_ShaderID_2D);
-    glDeleteProgram(m_ShaderID_3D);
-    glDeleteProgram(m_ShaderID_Skybox);
-    glDeleteVertexArrays(1, &m_SkyboxVAO);
-    glDeleteBuffers(1, &m_SkyboxVBO);
+  // Orphans and refills one light buffer; buffer textures cannot be empty, so an empty list uploads one zero texel.
+  void UploadLightBuffer(size_t index, const void* data, size_t bytes) {
+    static const glm::vec4 kEmpty(0.0f);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_LightBuffers[index]);
+    if (bytes == 0) {
+      glBufferData(GL_TEXTURE_BUFFER, sizeof(kEmpty), &kEmpty, GL_STREAM_DRAW);
+    }
+    else {
+      glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)bytes, data, GL_STREAM_DRAW);
+    }
   }
 
-private:
-  GLuint CompileShader(GLenum type, const char* source) {
-    GLuint id = glCreateShader(type);
-    glShaderSource(id, 1, &source, nullptr);
-    glCompileShader(id);
-
-    int result;
-    glGetShaderiv(id, GL_COMPILE_STATUS, &result);
-    if (result == GL_FALSE) {
-      int length;
-      glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
-      std::vector<char> message(length);
-      glGetShaderInfoLog(id, length, &length, message.data());
-      std::cerr << "Failed to compile shader (" << (type == GL_VERTEX_SHADER ? "Vertex" : "Fragment") << "):" << std::endl;
-      std::cerr << message.data() << std::endl;
-      glDeleteShader(id);
-      return 0;
+  // Only emits a geometry bind when the arena changes; arenas share one VAO per layout.
+  // Meshes culled per meshlet draw only their surviving index ranges.
+  // The cull mode is set by each list's first draw, so no list depends on the state another one left.
+  static void RecordDraw(CommandList& list, const RenderItem& item, const GeometryRange& range, const GeometryRange*& last_range, CullMode& last_cull_mode) {
+    if (!last_range || last_range->layout != range.layout || last_range->arena != range.arena) {
+      list.BindGeometry(range);
+    }
+    if (!last_range || item.cull_mode != last_cull_mode) {
+      list.SetCullMode(item.cull_mode);
+      last_cull_mode = item.cull_mode;
+    }
+    if (item.index_range_count > 0) {
+      list.DrawIndexedRanges(range, item.index_ranges, item.index_range_count);
     }
-    return id;
+    else {
+      list.DrawIndexed(range);
+    }
+    last_range = &range;
   }
 
-  GLuint CreateProgram(const char* vsSource, const char* fsSource) {
-    GLuint program = glCreateProgram();
-    GLuint vs = CompileShader(GL_VERTEX_SHADER, vsSource);
-    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, fsSource);
+  void ExecuteCommandList(const CommandList& list) {
+    GeometryPool* geometry_pool = device_->GetGeometryPool();
+
+    CommandList::Reader reader(list);
+    CommandHeader header;
+    while (reader.Next(header)) {
+      switch (header.type) {
+      case CommandType::BindProgram:
+        glUseProgram(reader.Read<CmdBindProgram>().program);
+        break;
+      case CommandType::BindGeometry:
+        geometry_pool->Bind(reader.Read<CmdBindGeometry>().range);
+        break;
+      case CommandType::BindTexture: {
+        auto cmd = reader.Read<CmdBindTexture>();
+        cmd.texture->Bind(cmd.slot);
+        break;
+      }
+      case CommandType::SetUniformInt: {
+        auto cmd = reader.Read<CmdUniformInt>();
+        glUniform1i(cmd.location, cmd.value);
+        break;
+      }
+      case CommandType::SetUniformFloat: {
+        auto cmd = reader.Read<CmdUniformFloat>();
+        glUniform1f(cmd.location, cmd.value);
+        break;
+      }
+      case CommandType::SetUniformVec3: {
+        auto cmd = reader.Read<CmdUniformVec3>();
+        glUniform3fv(cmd.location, 1, cmd.value);
+        break;
+      }
+      case CommandType::SetUniformMat3: {
+        auto cmd = reader.Read<CmdUniformMat3>();
+        glUniformMatrix3fv(cmd.location, 1, GL_FALSE, cmd.value);
+        break;
+      }
+      case CommandType::SetUniformMat4: {
+        auto cmd = reader.Read<CmdUniformMat4>();
+        glUniformMatrix4fv(cmd.location, 1, GL_FALSE, cmd.value);
+        break;
+      }
+      case CommandType::DrawIndexed:
+        DrawIndexed(reader.Read<CmdDrawIndexed>().range);
+        break;
+      case CommandType::DrawIndexedRanges: {
+        auto cmd = reader.Read<CmdDrawIndexedRanges>();
+        DrawIndexedRanges(cmd.range, cmd.ranges, cmd.range_count);
+        break;
+      }
+      case CommandType::SetCullMode:
+        SetCullMode(reader.Read<CmdSetCullMode>().mode);
+        break;
+      }
+    }
+  }
 
-    glAttachShader(program, vs);
-    glAttachShader(program, fs);
-    glLinkProgram(program);
-    glValidateProgram(program);
+  void SetCullMode(CullMode mode) {
+    if (mode == CullMode::None) {
+      glDisable(GL_CULL_FACE);
+      return;
+    }
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glFrontFace(mode == CullMode::BackMirrored ? GL_CW : GL_CCW);
+  }
 
-    glDeleteShader(vs);
-    glDeleteShader(fs);
+  void DrawIndexed(const GeometryRange& range) {
+    GLenum index_type = range.index_type == IndexType::UInt16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    glDrawElementsBaseVertex(GL_TRIANGLES, range.index_count, index_type, (const void*)(uintptr_t)range.index_offset, range.base_vertex);
+  }
 
-    return program;
- }
+  void DrawIndexedRanges(const GeometryRange& range, const IndexRange* ranges, uint32_t range_count) {
+    GLenum index_type = range.index_type == IndexType::UInt16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    uint32_t index_size = GetIndexSize(range.index_type);
+    multi_draw_counts_.resize(range_count);
+    multi_draw_offsets_.resize(range_count);
+    multi_draw_base_vertices_.assign(range_count, (GLint)range.base_vertex);
+    for (uint32_t i = 0; i < range_count; ++i) {
+      multi_draw_counts_[i] = (GLsizei)ranges[i].index_count;
+      multi_draw_offsets_[i] = (const void*)(uintptr_t)(range.index_offset + ranges[i].first_index * index_size);
+    }
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, multi_draw_counts_.data(), index_type, multi_draw_offsets_.data(),
+                                  (GLsizei)range_count, multi_draw_base_vertices_.data());
+  }
+
+  ~GLRenderingDriver() override {
+    glDeleteProgram(m_ShaderID_2D);
+    for (const auto& variant : m_ShaderVariants) {
+      glDeleteProgram(variant.program);
+    }
+    glDeleteProgram(m_ShaderID_Skybox);
+    glDeleteProgram(m_ShaderID_Depth);
+    glDeleteTextures((GLsizei)kLightBufferCount, m_LightTextures);
+    glDeleteBuffers((GLsizei)kLightBufferCount, m_LightBuffers);
+  }
 
 private:
   GLuint m_ShaderID_2D = 0; 
-  GLuint m_ShaderID_3D = 0; 
+  std::array<ShaderVariant, kShaderVariantCount> m_ShaderVariants{};
   GLuint m_ShaderID_Skybox = 0;
-  GLuint m_SkyboxVAO = 0;
-  GLuint m_SkyboxVBO = 0;
+  GLuint m_ShaderID_Depth = 0;
+  // The skybox is a single fullscreen triangle generated from gl_VertexID; core profile still wants a VAO bound.
+  GLContextVertexArray m_SkyboxVAO;
+
+  static constexpr size_t kLightBufferCount = 3;
+  static constexpr GLint kLightBufferFirstUnit = 1;
+  static constexpr const char* kLightBufferSamplers[kLightBufferCount] = { "lightData", "lightClusters", "lightIndices" };
+  GLuint m_LightBuffers[kLightBufferCount] = {};
+  GLuint m_LightTextures[kLightBufferCount] = {};
+  LightClusterGrid light_grid_;
+
+  GLGpuTimer gpu_timer_;
+  bool frame_timed_ = false;
+  mutable std::mutex stats_mutex_; // also guards upload_budget_
+  RenderStats stats_;
+  UploadBudget upload_budget_;
+  UploadQueue upload_queue_;
+  std::atomic<bool> log_gpu_timings_ = false;
+  std::array<float, (size_t)RenderPass::Count> logged_milliseconds_{};
+  uint32_t logged_frames_ = 0;
+  GLProgramCache program_cache_;
   std::shared_ptr<scene::Window> main_window_;
   RenderDevice* device_;
+
+  SceneSnapshot snapshot_; // single-threaded path only
+  RenderQueue render_queue_;
+  std::vector<CommandList> depth_lists_;
+  std::vector<CommandList> color_lists_;
+  std::vector<GLsizei> multi_draw_counts_; // scratch for DrawIndexedRanges
+  std::vector<const void*> multi_draw_offsets_;
+  std::vector<GLint> multi_draw_base_vertices_;
+  std::atomic<bool> depth_prepass_enabled_ = false; // toggled from the update thread
+  bool frame_depth_prepass_ = false;                // latched once per frame
 };
 
 std::unique_ptr<RenderingDriver> RenderingDriver::Create(RenderDevice* device) {
@@ -0,0 +1,166 @@
+#include "scene_snapshot.h"
+
+#include <algorithm>
+
+#include "scene/window.h"
+#include "scene/camera_3d.h"
+
+namespace wlw::rendering {
+
+  namespace {
+
+    glm::vec3 GetAxisScale(const glm::mat4& model) {
+      return glm::vec3(glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])));
+    }
+
+    // The coarsest LOD whose error covers at most kLodMaxPixelError pixels; `pixels_per_unit` is the
+    // mesh-space-to-screen scale at the node's distance.
+    std::shared_ptr<core::Mesh<core::Vertex3D>> SelectLod(const std::shared_ptr<core::Mesh<core::Vertex3D>>& mesh, float pixels_per_unit) {
+      std::shared_ptr<core::Mesh<core::Vertex3D>> selected = mesh;
+      for (const auto& lod : mesh->GetLods()) {
+        if (lod.error * pixels_per_unit > kLodMaxPixelError) {
+          break;
+        }
+        selected = lod.mesh;
+      }
+      return selected;
+    }
+
+    // Appends the meshlets of `proxy` that are inside the frustum and not back-facing to the snapshot's
+    // index ranges, merging neighbours. Returns false if none survived.
+    bool CullMeshlets(RenderProxy& proxy, const scene::Frustum& frustum, SceneSnapshot& snapshot) {
+      const auto& meshlets = proxy.mesh->GetMeshlets();
+      const glm::mat4& model = proxy.model;
+
+      // Bounds are in mesh space: spheres grow by the largest axis scale. Back-facing clusters are only
+      // dropped where the driver culls back faces anyway (single-sided materials), and the cone test is
+      // only exact under rotation and uniform scale without mirroring, so other transforms keep them.
+      glm::vec3 axis_scale = GetAxisScale(model);
+      float max_scale = std::max(axis_scale.x, std::max(axis_scale.y, axis_scale.z));
+      float min_scale = std::min(axis_scale.x, std::min(axis_scale.y, axis_scale.z));
+      bool cone_culling = !proxy.double_sided && !proxy.mirrored && min_scale > 0.0f && max_scale / min_scale < 1.001f;
+      glm::mat3 linear = glm::mat3(model);
+
+      size_t first_range = snapshot.index_ranges.size();
+      uint32_t visible = 0;
+      for (const auto& meshlet : meshlets) {
+        glm::vec3 center = glm::vec3(model * glm::vec4(meshlet.center, 1.0f));
+        float radius = meshlet.radius * max_scale;
+        if (!frustum.TestSphere(center, radius)) {
+          continue;
+        }
+        if (cone_culling) {
+          glm::vec3 cone_axis = linear * meshlet.cone_axis / max_scale;
+          if (core::IsMeshletBackFacing(center, radius, cone_axis, meshlet.cone_cutoff, snapshot.camera_position)) {
+            continue;
+          }
+        }
+
+        visible++;
+        if (snapshot.index_ranges.size() > first_range) {
+          IndexRange& last = snapshot.index_ranges.back();
+          if (last.first_index + last.index_count == meshlet.first_index) {
+            last.index_count += meshlet.index_count;
+            continue;
+          }
+        }
+        snapshot.index_ranges.push_back({ meshlet.first_index, meshlet.index_count });
+      }
+
+      snapshot.visible_meshlets += visible;
+      snapshot.culled_meshlets += (uint32_t)meshlets.size() - visible;
+      if (visible == meshlets.size()) {
+        // Everything survived: one contiguous range, drawn as the whole mesh.
+        snapshot.index_ranges.resize(first_range);
+        return true;
+      }
+      proxy.first_index_range = (uint32_t)first_range;
+      proxy.index_range_count = (uint32_t)(snapshot.index_ranges.size() - first_range);
+      return visible > 0;
+    }
+
+  } // namespace
+
+  void ExtractSceneSnapshot(scene::Window& window, SceneSnapshot& snapshot) {
+    snapshot.Clear();
+    snapshot.viewport_size = window.GetSize();
+    snapshot.skybox = window.GetSkybox();
+
+    auto camera = window.GetUpdatedCamera();
+    snapshot.view = camera->GetViewMatrix();
+    snapshot.projection = camera->GetProjectionMatrix();
+    snapshot.camera_position = glm::vec3(camera->GetPosition());
+
+    for (const auto& [_, light] : window.GetLights()) {
+      snapshot.lights.push_back(*light);
+    }
+
+    scene::Frustum frustum = scene::Frustum::FromMatrix(snapshot.projection * snapshot.view);
+    uint32_t object_id = 0;
+
+    window.IterateOver3DNodes([&](const std::shared_ptr<scene::Node3D> node) {
+      auto model = node->GetModel();
+      if (model == nullptr || model->meshes.empty()) {
+        return;
+      }
+
+      scene::AABB aabb = node->GetAABB();
+      if (!frustum.TestAABB(aabb)) {
+        return;
+      }
+
+      glm::vec3 center = (glm::vec3(aabb.min) + glm::vec3(aabb.max)) * 0.5f;
+      float view_depth = -(snapshot.view * glm::vec4(center, 1.0f)).z;
+      auto node_mat = node->GetMaterial();
+      object_id++;
+
+      glm::mat4 node_model = node->GetModelMatrix();
+      bool mirrored = glm::determinant(glm::mat3(node_model)) < 0.0f;
+      glm::vec3 axis_scale = GetAxisScale(node_model);
+      float distance = std::max(glm::length(center - snapshot.camera_position), 1e-3f);
+      float pixels_per_unit = snapshot.viewport_size.y * 0.5f * snapshot.projection[1][1] *
+                              std::max(axis_scale.x, std::max(axis_scale.y, axis_scale.z)) / distance;
+
+      for (const auto& mesh : model->meshes) {
+        if (mesh->GetIndexCount() == 0) {
+          continue;
+        }
+
+        RenderProxy proxy;
+        proxy.mesh = SelectLod(mesh, pixels_per_unit);
+        proxy.mesh->Publish();
+        if (proxy.mesh != mesh) {
+          proxy.fallback_mesh = mesh;
+          mesh->Publish();
+        }
+        proxy.model = node_model;
+        proxy.normal_matrix = node->GetNormalMatrix();
+        proxy.object_id = object_id;
+        proxy.view_depth = view_depth;
+        proxy.mirrored = mirrored;
+
+        for (const auto& material : { node_mat, mesh->GetMaterial() }) {
+          if (!material) {
+            continue;
+          }
+          if (material->HasTexture()) {
+            proxy.texture = material->GetTexture();
+          }
+          if (material->IsLit()) {
+            proxy.lit = true;
+            proxy.shininess = material->shininess;
+          }
+          proxy.base_color = glm::vec3(material->base_color.r, material->base_color.g, material->base_color.b);
+          proxy.double_sided = material->IsDoubleSided();
+        }
+
+        if (!proxy.mesh->GetMeshlets().empty() && !CullMeshlets(proxy, frustum, snapshot)) {
+          continue;
+        }
+
+        snapshot.proxies.push_back(std::move(proxy));
+      }
+    });
+  }
+
+} // namespace wlw::rendering
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "core/mesh.h"
+#include "core/vector2.h"
+#include "core/vertex_3d.h"
+#include "rendering/geometry_pool.h"
+#include "rendering/light.h"
+#include "rendering/material.h"
+#include "rendering/texture.h"
+
+namespace wlw::scene {
+  class Window;
+}
+
+namespace wlw::rendering {
+
+  // A mesh switches to a coarser LOD once that LOD's error would cover no more than this many pixels.
+  constexpr float kLodMaxPixelError = 1.0f;
+
+  // Everything the renderer needs to draw one mesh, copied out of the scene graph so the render
+  // thread never reads nodes or materials the update thread may be mutating. Meshes are shared rather
+  // than copied: ExtractSceneSnapshot publishes each one it hands over, which makes it immutable on the
+  // update thread (see core::Mesh), and from then on only the render thread touches its GPU geometry.
+  struct RenderProxy {
+    std::shared_ptr<core::Mesh<core::Vertex3D>> mesh; // the LOD selected for this frame
+    std::shared_ptr<core::Mesh<core::Vertex3D>> fallback_mesh; // full mesh, drawn while that LOD is not resident
+    glm::mat4 model = glm::mat4(1.0f);
+    glm::mat3 normal_matrix = glm::mat3(1.0f);
+
+    // Material state resolved the same way it used to be bound: mesh material overrides node material.
+    std::shared_ptr<WTexture> texture;
+    bool lit = false;
+    float shininess = 32.0f;
+    glm::vec3 base_color = glm::vec3(1.0f);
+    bool double_sided = true; // of the mesh material if it has one, else of the node material
+    bool mirrored = false;    // negative-determinant transform: front faces wind clockwise on screen
+
+    uint32_t object_id = 0; // proxies of the same node share an id (and a transform)
+    float view_depth = 0.0f;
+
+    // Meshlets that survived culling, as SceneSnapshot::index_ranges[first_index_range, +index_range_count).
+    // Zero ranges means the whole mesh is drawn.
+    uint32_t first_index_range = 0;
+    uint32_t index_range_count = 0;
+  };
+
+  struct SceneSnapshot {
+    core::Vector2 viewport_size = { 0.0f, 0.0f };
+
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::vec3 camera_position = glm::vec3(0.0f);
+
+    std::vector<RenderProxy> proxies; // already frustum culled
+    std::vector<IndexRange> index_ranges; // surviving meshlets, adjacent ones merged
+    uint32_t visible_meshlets = 0;
+    uint32_t culled_meshlets = 0;
+    std::vector<Lighting> lights;
+    std::shared_ptr<WCubemap> skybox;
+
+    void Clear() {
+      proxies.clear();
+      index_ranges.clear();
+      visible_meshlets = 0;
+      culled_meshlets = 0;
+      lights.clear();
+      skybox = nullptr;
+    }
+  };
+
+  // Walks the window's scene graph on the calling (update) thread and fills `snapshot` with the
+  // camera, lights and the visible proxies, each at the LOD its distance allows, culling meshes with
+  // meshlets down to their visible clusters (and front-facing ones, for single-sided materials). Touches no graphics API.
+  void ExtractSceneSnapshot(scene::Window& window, SceneSnapshot& snapshot);
+
+} // namespace wlw::rendering
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "rendering/scene_snapshot.h"
+
+namespace wlw::rendering {
+
+  // Feature bits of the 3D color program. Every combination is its own program built with matching
+  // #defines, so fragments never branch on material state at runtime.
+  enum ShaderFeature : uint32_t {
+    ShaderFeatureTexture = 1u << 0,
+    ShaderFeatureLighting = 1u << 1,
+    ShaderFeaturePackedVertex = 1u << 2, // geometry in VertexLayout::Packed3D
+  };
+
+  constexpr uint32_t kShaderVariantCount = 1u << 3;
+
+  inline uint32_t GetShaderVariant(const RenderProxy& proxy) {
+    uint32_t variant = 0;
+    if (proxy.texture) {
+      variant |= ShaderFeatureTexture;
+    }
+    if (proxy.lit) {
+      variant |= ShaderFeatureLighting;
+    }
+    return variant;
+  }
+
+  inline std::string GetShaderDefines(uint32_t variant) {
+    std::string defines;
+    if (variant & ShaderFeatureTexture) {
+      defines += "#define USE_TEXTURE\n";
+    }
+    if (variant & ShaderFeatureLighting) {
+      defines += "#define USE_LIGHTING\n";
+    }
+    if (variant & ShaderFeaturePackedVertex) {
+      defines += "#define PACKED_VERTEX\n";
+    }
+    return defines;
+  }
+
+  // #version has to stay the first statement, so defines go right after that line.
+  inline std::string InjectShaderDefines(const std::string& source, const std::string& defines) {
+    size_t version = source.find("#version");
+    if (version == std::string::npos) {
+      return defines + source;
+    }
+    size_t line_end = source.find('\n', version);
+    if (line_end == std::string::npos) {
+      return source + "\n" + defines;
+    }
+    return source.substr(0, line_end + 1) + defines + source.substr(line_end + 1);
+  }
+
+} // namespace wlw::rendering
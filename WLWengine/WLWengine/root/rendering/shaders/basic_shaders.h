@@ -32,7 +32,27 @@ const char* vertex3DShaderSource = R"(
 #version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec4 aColor;
+#ifdef PACKED_VERTEX
+// core::PackedVertex3D. Positions need no decoding here: the model matrix carries the dequantization.
+layout (location = 2) in vec2 aNormal;
+
+vec3 DecodeNormal(vec2 encoded)
+{
+    vec2 e = encoded / 32767.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+#else
 layout (location = 2) in vec3 aNormal;
+
+vec3 DecodeNormal(vec3 normal)
+{
+    return normal;
+}
+#endif
 layout (location = 3) in vec2 UV;
 
 out vec3 vertexColor;
@@ -40,26 +60,36 @@ out vec3 vertexNormal;
 out vec3 vertexNormal1;
 out vec3 vertexPos;
 out vec2 vertUV;
+out float viewDepth;
 
 uniform mat4 model;
+uniform mat3 normalMatrix; // computed once per object on the CPU
 uniform mat4 view;
 uniform mat4 projection;
 
+// Must match depthVertexShaderSource bit for bit, the color pass depth tests against the pre-pass.
+invariant gl_Position;
+
 void main()
 {
     vec4 worldPos = model * vec4(aPos, 1.0);
-    vertexNormal = normalize(mat3(transpose(inverse(model))) * aNormal);
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vec3 normal = DecodeNormal(aNormal);
+    vertexNormal = normalize(normalMatrix * normal);
+    gl_Position = projection * view * worldPos;
 
     vertexPos = worldPos.xyz;
+    viewDepth = -(view * worldPos).z;
     vertexColor = aColor.xyz;
     vertUV = UV;
-    vertexNormal1 = aNormal;
+    vertexNormal1 = normal;
 }
 
 )";
 
 
+// Specialized per variant (see rendering/shader_variant.h): USE_TEXTURE and USE_LIGHTING are defined
+// right after #version. Lit variants shade with the directional lights plus the point / spot lights of
+// the fragment's cluster (see rendering/light_clusters.h for the buffer layouts).
 const char* fragment3DShaderSource = R"(
 #version 330 core
 
@@ -68,72 +98,96 @@ in vec3 vertexNormal;
 in vec3 vertexPos;
 in vec2 vertUV;
 in vec3 vertexNormal1;
+in float viewDepth;
+
+#ifdef USE_LIGHTING
+#define MAX_DIRECTIONAL_LIGHTS 4
+#define TEXELS_PER_LIGHT 5
 
 uniform vec3 viewPos;
-uniform int lightType; // 0 = Directional, 1 = Point, 2 = Spot
-uniform vec3 lightPos;
-uniform vec3 lightDir;
-uniform vec3 lightColor;
-uniform bool useLighting;
-uniform float ambientStrength;
 uniform float shininess;
 
-uniform float lightConstant;
-uniform float lightLinear;
-uniform float lightQuadratic;
-uniform float lightCutOff;
-uniform float lightOuterCutOff;
+uniform int directionalLightCount;
+uniform vec4 directionalLights[MAX_DIRECTIONAL_LIGHTS * 2]; // (direction, ambient) (color, -)
+
+uniform samplerBuffer lightData;
+uniform usamplerBuffer lightClusters; // (first index, count) per cluster
+uniform usamplerBuffer lightIndices;
+uniform ivec3 clusterDims;
+uniform vec2 clusterTileSize;
+uniform vec2 clusterSliceScaleBias;
+
+vec3 Shade(vec3 norm, vec3 viewDir, vec3 lightDir, vec3 lightColor, float ambientStrength, float attenuation, float intensity)
+{
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+
+    float diff = max(dot(norm, lightDir), 0.0);
+    float spec = (diff > 0.0) ? pow(max(dot(norm, halfwayDir), 0.0), shininess) : 0.0;
 
-uniform bool use_texture;
+    return (ambientStrength * attenuation + (diff + spec) * attenuation * intensity) * lightColor;
+}
+#endif
+
+#ifdef USE_TEXTURE
 uniform sampler2D model_texture; 
+#endif
+
+uniform vec3 baseColor; // material tint
 
 out vec4 FragColor;
 
 void main()
 {
-    vec3 objectColor = use_texture ? texture(model_texture, vertUV).xyz : vertexColor;
-
-    if (!useLighting) {
-      FragColor = vec4(objectColor, 1.0);
-      return;
-    }
-
+#ifdef USE_TEXTURE
+    vec3 objectColor = texture(model_texture, vertUV).xyz * baseColor;
+#else
+    vec3 objectColor = vertexColor * baseColor;
+#endif
+
+#ifndef USE_LIGHTING
+    FragColor = vec4(objectColor, 1.0);
+#else
     vec3 norm = normalize(vertexNormal);
     vec3 viewDir = normalize(viewPos - vertexPos);
-    
-    vec3 lightDirCalc;
-    float attenuation = 1.0;
-    float intensity = 1.0;
-
-    if (lightType == 0) { // Directional
-        lightDirCalc = normalize(-lightDir);
-    } else { // Point or Spot
-        lightDirCalc = normalize(lightPos - vertexPos);
-        float distance = length(lightPos - vertexPos);
-        attenuation = 1.0 / (lightConstant + lightLinear * distance + lightQuadratic * (distance * distance));
-        
-        if (lightType == 2) { // Spot
-            float theta = dot(lightDirCalc, normalize(-lightDir));
-            float epsilon = lightCutOff - lightOuterCutOff;
-            intensity = clamp((theta - lightOuterCutOff) / epsilon, 0.0, 1.0);
-        }
-    }
-
-    vec3 halfwayDir = normalize(lightDirCalc + viewDir);
-
-    vec3 ambient = ambientStrength * lightColor;
+    vec3 result = vec3(0.0);
 
-    float diff = max(dot(norm, lightDirCalc), 0.0);
-    vec3 diffuse = diff * lightColor;
+    for (int i = 0; i < directionalLightCount; ++i) {
+        vec4 dirAmbient = directionalLights[i * 2];
+        vec4 color = directionalLights[i * 2 + 1];
+        result += Shade(norm, viewDir, normalize(-dirAmbient.xyz), color.rgb, dirAmbient.w, 1.0, 1.0);
+    }
 
-    float spec = pow(max(dot(norm, halfwayDir), 0.0), shininess);
-    vec3 specular = (diff > 0.0) ? spec * lightColor : vec3(0.0);
+    ivec3 cluster = ivec3(ivec2(gl_FragCoord.xy / clusterTileSize),
+                          int(log(max(viewDepth, 1e-4)) * clusterSliceScaleBias.x + clusterSliceScaleBias.y));
+    cluster = clamp(cluster, ivec3(0), clusterDims - 1);
+    uvec2 record = texelFetch(lightClusters, (cluster.z * clusterDims.y + cluster.y) * clusterDims.x + cluster.x).xy;
+
+    for (uint i = 0u; i < record.y; ++i) {
+        int base = int(texelFetch(lightIndices, int(record.x + i)).r) * TEXELS_PER_LIGHT;
+        vec4 posRange = texelFetch(lightData, base);
+        vec4 colorAmbient = texelFetch(lightData, base + 1);
+        vec4 dirType = texelFetch(lightData, base + 2);
+        vec4 falloff = texelFetch(lightData, base + 3);
+
+        vec3 toLight = posRange.xyz - vertexPos;
+        float distance = length(toLight);
+        vec3 lightDirCalc = toLight / max(distance, 1e-4);
+
+        // Smoothly reaches zero at the culling range so lights never pop at cluster edges.
+        float window = clamp(1.0 - pow(distance / posRange.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (falloff.x + falloff.y * distance + falloff.z * (distance * distance));
+
+        float intensity = 1.0;
+        if (dirType.w > 1.5) { // Spot
+            vec2 cone = texelFetch(lightData, base + 4).xy;
+            float theta = dot(lightDirCalc, -dirType.xyz);
+            intensity = clamp((theta - cone.y) / (cone.x - cone.y), 0.0, 1.0);
+        }
 
-    ambient *= attenuation;
-    diffuse *= attenuation * intensity;
-    specular *= attenuation * intensity;
+        result += Shade(norm, viewDir, lightDirCalc, colorAmbient.rgb, colorAmbient.w, attenuation, intensity);
+    }
 
-    vec3 result = (ambient + diffuse + specular) * objectColor;
-    FragColor = vec4(result, 1.0);
+    FragColor = vec4(result * objectColor, 1.0);
+#endif
 }
 )";
@@ -0,0 +1,27 @@
+#pragma once
+
+// Position-only program for the depth pre-pass. gl_Position must be computed exactly like
+// vertex3DShaderSource (and both declared invariant) so the color pass can depth test against it.
+const char* depthVertexShaderSource = R"(
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+invariant gl_Position;
+
+void main()
+{
+    vec4 worldPos = model * vec4(aPos, 1.0);
+    gl_Position = projection * view * worldPos;
+}
+)";
+
+const char* depthFragmentShaderSource = R"(
+#version 330 core
+void main()
+{
+}
+)";
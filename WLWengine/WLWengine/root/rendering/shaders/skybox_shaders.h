@@ -1,21 +1,21 @@
 #pragma once
 
+// Fullscreen triangle at the far plane. The cube direction is recovered by unprojecting the
+// clip-space position with the inverse of (projection * rotation-only view).
 const char* skyboxVertexShaderSource = R"(
 #version 330 core
-layout (location = 0) in vec3 aPos;
-
 out vec3 TexCoords;
 
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat4 inverseViewProjection;
 
 void main()
 {
-    TexCoords = aPos;
-    // We remove the translation part of the view matrix to keep the skybox centered
-    mat4 staticView = mat4(mat3(view)); 
-    vec4 pos = projection * staticView * vec4(aPos, 1.0);
-    gl_Position = pos.xyww; // Force depth to 1.0 (maximum depth)
+    // (-1,-1), (3,-1), (-1,3): covers the whole screen with a single triangle
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+
+    vec4 world = inverseViewProjection * vec4(pos, 1.0, 1.0);
+    TexCoords = world.xyz / world.w;
+    gl_Position = vec4(pos, 1.0, 1.0); // Force depth to 1.0 (maximum depth)
 }
 )";
 
@@ -8,6 +8,9 @@ public:
     virtual ~WTexture() = default;
     virtual void Bind(unsigned int slot = 0) const = 0;
     virtual void Unbind() const = 0;
+
+    // False while the pixels are still being uploaded; draws should skip the texture until then.
+    virtual bool IsReady() const { return true; }
     
     unsigned int GetID() const { return gpu_id_; }
 
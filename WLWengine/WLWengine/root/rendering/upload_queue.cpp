@@ -0,0 +1,67 @@
+#include "upload_queue.h"
+
+#include <chrono>
+
+namespace wlw::rendering {
+
+  size_t UploadQueue::GetUploadSize(const core::Mesh<core::Vertex3D>& mesh) {
+    size_t vertex_size = mesh.HasPackedVertices() ? sizeof(core::PackedVertex3D) : sizeof(core::Vertex3D);
+    size_t index_size = GetIndexSize(SelectIndexType((uint32_t)mesh.GetVertices().size()));
+    return mesh.GetVertices().size() * vertex_size + mesh.GetIndices().size() * index_size;
+  }
+
+  void UploadQueue::Request(const MeshPtr& mesh) {
+    if (!queued_.insert(mesh.get()).second) {
+      return;
+    }
+    size_t bytes = GetUploadSize(*mesh);
+    pending_.push_back({ mesh, bytes });
+    pending_bytes_ += bytes;
+  }
+
+  size_t UploadQueue::Drain(GeometryPool* geometry_pool, const UploadBudget& budget) {
+    auto start = std::chrono::steady_clock::now();
+    size_t uploaded = 0;
+    bool first = true;
+
+    while (!pending_.empty()) {
+      MeshPtr mesh = pending_.front().mesh;
+      size_t size = GetUploadSize(*mesh);
+
+      if (!first) {
+        float elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (uploaded + size > budget.bytes || elapsed >= budget.milliseconds) {
+          break;
+        }
+      }
+
+      pending_bytes_ -= pending_.front().bytes;
+      pending_.pop_front();
+      queued_.erase(mesh.get());
+
+      // Skip meshes the scene dropped while they waited, ones that got their geometry some other way, and
+      // ones whose CPU data a residency policy already released.
+      if (mesh.use_count() == 1 || mesh->GetGeometry() || mesh->IsCpuDataReleased()) {
+        continue;
+      }
+
+      // Packing runs here rather than in SetVertices so the CPU copy stays editable and full precision.
+      if (mesh->HasPackedVertices()) {
+        mesh->SetGeometry(geometry_pool->Allocate(core::PackVertices(mesh->GetVertices()), mesh->GetIndices()));
+      }
+      else {
+        mesh->SetGeometry(geometry_pool->Allocate(mesh->GetVertices(), mesh->GetIndices()));
+      }
+      first = false;
+      if (!mesh->GetGeometry()) {
+        // The pool is full: keep the CPU copy so the mesh can be requested again once space frees up.
+        continue;
+      }
+      mesh->OnGeometryUploaded();
+      uploaded += size;
+    }
+
+    return uploaded;
+  }
+
+} // namespace wlw::rendering
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_set>
+
+#include "core/mesh.h"
+#include "rendering/geometry_pool.h"
+
+namespace wlw::rendering {
+
+  // How much geometry one frame may push into the geometry pool. At least one mesh is always uploaded
+  // per frame, so a mesh bigger than the budget still gets in, it just has the frame to itself.
+  struct UploadBudget {
+    size_t bytes = 4u << 20;
+    float milliseconds = 2.0f;
+  };
+
+  // Meshes that became visible without being resident wait here and are moved into the geometry pool a
+  // budget's worth per frame, so a model appearing costs a few frames of latency instead of one long one.
+  // Render thread only.
+  class UploadQueue {
+  public:
+    using MeshPtr = std::shared_ptr<core::Mesh<core::Vertex3D>>;
+
+    // Queues `mesh` once; requests for meshes that are already queued are ignored.
+    void Request(const MeshPtr& mesh);
+
+    // Uploads queued meshes in request order until the budget runs out. Returns the bytes uploaded.
+    size_t Drain(GeometryPool* geometry_pool, const UploadBudget& budget);
+
+    size_t GetPendingCount() const { return pending_.size(); }
+    size_t GetPendingBytes() const { return pending_bytes_; }
+
+    static size_t GetUploadSize(const core::Mesh<core::Vertex3D>& mesh);
+
+  private:
+    struct PendingUpload {
+      MeshPtr mesh;
+      size_t bytes; // as queued; Drain recomputes it since a residency policy may release the CPU data first
+    };
+
+    std::deque<PendingUpload> pending_;
+    std::unordered_set<const core::Mesh<core::Vertex3D>*> queued_;
+    size_t pending_bytes_ = 0;
+  };
+
+} // namespace wlw::rendering
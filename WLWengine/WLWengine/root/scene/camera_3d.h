@@ -64,6 +64,15 @@ namespace wlw::scene {
             }
             return true;
         }
+
+        bool TestSphere(const glm::vec3& center, float radius) const {
+            for (const auto& plane : planes) {
+                if (plane.GetDistanceToPoint(center) < -radius) {
+                    return false;
+                }
+            }
+            return true;
+        }
     };
 
 	enum class CameraMovement {
@@ -113,6 +113,11 @@ public:
 		return model_matrix_;
 	}
 
+	// Inverse-transpose of the model matrix, refreshed together with it so shaders never invert per vertex.
+	const glm::mat3& GetNormalMatrix() const {
+		return normal_matrix_;
+	}
+
 	void SetMaterial(std::shared_ptr<rendering::Material> material) {
 		material_ = material;
 
@@ -158,6 +163,14 @@ private:
 
 		// 3. Apply SCALE (Scale around local origin)
 		model_matrix_ = glm::scale(model_matrix_, glm::vec3(scale_.x, scale_.y, scale_.z));
+
+		// Rotation * uniform scale is already orthogonal up to a factor the shader normalizes away.
+		if (scale_.x == scale_.y && scale_.y == scale_.z) {
+			normal_matrix_ = glm::mat3(model_matrix_);
+		}
+		else {
+			normal_matrix_ = glm::transpose(glm::inverse(glm::mat3(model_matrix_)));
+		}
 	}
 
 private:
@@ -168,6 +181,7 @@ private:
 	core::Vector3 rotation_angles_degrees_ = { 0,0,0 };
 
 	glm::mat4 model_matrix_ = glm::mat4(1.0f);
+	glm::mat3 normal_matrix_ = glm::mat3(1.0f);
 
 	std::shared_ptr<rendering::Material> material_;
 
@@ -0,0 +1,154 @@
+#include "static_batcher.h"
+
+#include <cmath>
+#include <glm/glm.hpp>
+
+namespace wlw::scene {
+
+  namespace {
+
+    // One merged mesh: everything in a chunk drawn with the same node and mesh material.
+    using BatchKey = std::pair<rendering::Material*, rendering::Material*>;
+
+    struct Batch {
+      std::shared_ptr<rendering::Material> node_material;
+      std::shared_ptr<rendering::Material> mesh_material;
+      std::vector<core::Vertex3D> vertices;
+      std::vector<uint32_t> indices;
+    };
+
+    void AppendTransformed(Batch& batch, const core::Mesh<core::Vertex3D>& mesh, const glm::mat4& model, const glm::mat3& normal_matrix) {
+      uint32_t base = (uint32_t)batch.vertices.size();
+      batch.vertices.reserve(batch.vertices.size() + mesh.GetVertices().size());
+      for (core::Vertex3D vertex : mesh.GetVertices()) {
+        glm::vec4 position = model * glm::vec4(vertex.position.x, vertex.position.y, vertex.position.z, 1.0f);
+        glm::vec3 normal = normal_matrix * glm::vec3(vertex.normal.x, vertex.normal.y, vertex.normal.z);
+        float length = glm::length(normal);
+        if (length > 0.0f) {
+          normal = normal / length;
+        }
+        vertex.position = { position.x, position.y, position.z };
+        vertex.normal = { normal.x, normal.y, normal.z };
+        batch.vertices.push_back(vertex);
+      }
+      batch.indices.reserve(batch.indices.size() + mesh.GetIndices().size());
+      for (uint32_t index : mesh.GetIndices()) {
+        batch.indices.push_back(base + index);
+      }
+    }
+
+    // Children move with their parent and meshes without CPU data cannot be merged: such nodes stay as they are.
+    bool IsBatchable(const Node3D& node) {
+      auto model = node.GetModel();
+      if (!model || !node.GetChildren().empty()) {
+        return false;
+      }
+      for (const auto& mesh : model->meshes) {
+        if (mesh->IsCpuDataReleased()) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+  } // namespace
+
+  int StaticBatcher::Add(const std::shared_ptr<Node3D>& node) {
+    int id = next_id_++;
+    ChunkKey key = GetChunkKey(*node);
+    Chunk& chunk = chunks_[key];
+    chunk.nodes[id] = node;
+    chunk.dirty = true;
+    node_chunks_[id] = key;
+    return id;
+  }
+
+  void StaticBatcher::Remove(int id) {
+    auto it = node_chunks_.find(id);
+    if (it == node_chunks_.end()) {
+      return;
+    }
+    Chunk& chunk = chunks_[it->second];
+    chunk.nodes.erase(id);
+    chunk.dirty = true;
+    node_chunks_.erase(it);
+  }
+
+  void StaticBatcher::Build(Window& window) {
+    for (auto it = chunks_.begin(); it != chunks_.end();) {
+      Chunk& chunk = it->second;
+      if (chunk.dirty) {
+        BuildChunk(chunk, window);
+      }
+      it = chunk.nodes.empty() ? chunks_.erase(it) : std::next(it);
+    }
+  }
+
+  void StaticBatcher::Clear(Window& window) {
+    for (auto& [_, chunk] : chunks_) {
+      for (int id : chunk.window_ids) {
+        window.RemoveNode3D(id);
+      }
+    }
+    chunks_.clear();
+    node_chunks_.clear();
+  }
+
+  size_t StaticBatcher::GetBatchCount() const {
+    size_t count = 0;
+    for (const auto& [_, chunk] : chunks_) {
+      count += chunk.window_ids.size();
+    }
+    return count;
+  }
+
+  StaticBatcher::ChunkKey StaticBatcher::GetChunkKey(const Node3D& node) const {
+    core::Vector3 position = node.GetPosition();
+    return { (int)std::floor(position.x / chunk_size_), (int)std::floor(position.y / chunk_size_), (int)std::floor(position.z / chunk_size_) };
+  }
+
+  void StaticBatcher::BuildChunk(Chunk& chunk, Window& window) {
+    for (int id : chunk.window_ids) {
+      window.RemoveNode3D(id);
+    }
+    chunk.window_ids.clear();
+    chunk.dirty = false;
+
+    std::map<BatchKey, Batch> batches;
+    for (const auto& [_, node] : chunk.nodes) {
+      if (!IsBatchable(*node)) {
+        chunk.window_ids.push_back(window.AddNode(node));
+        continue;
+      }
+      const glm::mat4& model = node->GetModelMatrix();
+      const glm::mat3& normal_matrix = node->GetNormalMatrix();
+      for (const auto& mesh : node->GetModel()->meshes) {
+        Batch& batch = batches[{ node->GetMaterial().get(), mesh->GetMaterial().get() }];
+        batch.node_material = node->GetMaterial();
+        batch.mesh_material = mesh->GetMaterial();
+        AppendTransformed(batch, *mesh, model, normal_matrix);
+      }
+    }
+
+    for (auto& [_, batch] : batches) {
+      if (batch.indices.empty()) {
+        continue;
+      }
+      auto mesh = std::make_shared<core::Mesh<core::Vertex3D>>();
+      mesh->name = "static_batch";
+      mesh->SetVertices(std::move(batch.vertices));
+      mesh->SetIndices(std::move(batch.indices));
+      mesh->SetMaterial(batch.mesh_material);
+
+      auto model = std::make_shared<core::Model<core::Vertex3D>>();
+      model->meshes.push_back(mesh);
+      auto node = std::make_shared<Node3D>();
+      node->SetModel(model);
+      if (batch.node_material) {
+        node->SetMaterial(batch.node_material);
+      }
+      chunk.window_ids.push_back(window.AddNode(node));
+    }
+  }
+
+} // namespace wlw::scene
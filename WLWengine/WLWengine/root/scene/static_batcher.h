@@ -0,0 +1,54 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "scene/window.h"
+
+namespace wlw::scene {
+
+  // Bakes immovable nodes into one pre-transformed mesh per material per spatial chunk, so a tile level
+  // draws a handful of batches instead of a node per tile. Each batch is an ordinary node with its own
+  // bounds, so chunks are still frustum culled individually.
+  //
+  // Nodes given to the batcher must not also be added to the window. Their transform, model and material
+  // are read when their chunk is built; changing them afterwards has no effect until Remove + Add.
+  class StaticBatcher {
+  public:
+    static constexpr float kDefaultChunkSize = 16.0f;
+
+    explicit StaticBatcher(float chunk_size = kDefaultChunkSize) : chunk_size_(chunk_size) {}
+
+    int Add(const std::shared_ptr<Node3D>& node);
+    void Remove(int id);
+
+    // Replaces the batch nodes of every chunk changed since the last call; untouched chunks are kept.
+    void Build(Window& window);
+
+    // Takes every batch node back out of `window` and forgets all nodes.
+    void Clear(Window& window);
+
+    size_t GetBatchCount() const;
+
+  private:
+    using ChunkKey = std::tuple<int, int, int>;
+
+    struct Chunk {
+      std::map<int, std::shared_ptr<Node3D>> nodes;
+      std::vector<int> window_ids; // batch (and unbatchable) nodes currently in the window
+      bool dirty = true;
+    };
+
+    ChunkKey GetChunkKey(const Node3D& node) const;
+    void BuildChunk(Chunk& chunk, Window& window);
+
+    float chunk_size_;
+    int next_id_ = 0;
+    std::map<ChunkKey, Chunk> chunks_;
+    std::unordered_map<int, ChunkKey> node_chunks_;
+  };
+
+} // namespace wlw::scene
@@ -5,6 +5,7 @@
 
 
 #include "core/logger.h"
+#include <climits>
 #include <iostream>
 #include <unordered_map>
 
@@ -46,21 +47,25 @@ public:
 	void MakeContextCurrent() override {
 		ASSERT_GLFW_WINDOW_NOT_NULL(window_);
 		glfwMakeContextCurrent(window_);
-		glfwSwapInterval(1);
+	}
+
+	void ReleaseContext() override {
+		if (glfwGetCurrentContext() == window_) {
+			glfwMakeContextCurrent(NULL);
+		}
 	}
 
 	void ProcessEvents() override {
 		ASSERT_GLFW_WINDOW_NOT_NULL(window_);
 		// Input processing
 		processInput();
+	}
 
-		// --- Actual Render Logic Goes Here ---
-
+	void SwapBuffers() override {
+		ASSERT_GLFW_WINDOW_NOT_NULL(window_);
+		ApplySwapInterval();
 		// Swap the front and back buffers to display the rendered image
 		glfwSwapBuffers(window_);
-
-		// Check and call events (like input, window resize, etc.)
-		glfwPollEvents();
 	}
 
 
@@ -78,6 +83,20 @@ public:
 
 private:
 
+	// The swap interval is context state and changing it can stall some drivers, so it is only set when it changed.
+	void ApplySwapInterval() {
+		int interval = swap_interval_;
+		if (interval == applied_swap_interval_) {
+			return;
+		}
+		applied_swap_interval_ = interval;
+
+		if (interval < 0 && !glfwExtensionSupported("WGL_EXT_swap_control_tear") && !glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+			interval = 1;
+		}
+		glfwSwapInterval(interval);
+	}
+
 	//TODO: Move to somehwere else (like input manager)
 	void processInput() {
 	
@@ -154,9 +173,19 @@ private:
 	GLFWwindow* window_;
 	core::Color color_;
 	std::string title_;
+	int applied_swap_interval_ = INT_MIN; // context thread only
 
 };
 
+void Window::ReleaseCurrentContext() {
+	glfwMakeContextCurrent(NULL);
+}
+
+void Window::PollEvents() {
+	// Check and call events (like input, window resize, etc.) for all windows
+	glfwPollEvents();
+}
+
 std::unique_ptr<Window> Window::Create(const core::Vector2& size, const std::string& title) {
 	return std::make_unique<WindowImpl>(size, title);
 }	
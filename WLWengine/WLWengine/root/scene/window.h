@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -17,9 +18,12 @@
 #include "scene/camera_3d.h"
 #include "scene/fps_camera.h"
 #include "rendering/texture.h"
+#include "rendering/light.h"
 
 namespace wlw::scene {
 
+using LightsMap = std::unordered_map<int, std::shared_ptr<rendering::Lighting>>;
+
 class Window {
 public:
 
@@ -28,7 +32,25 @@ public:
 	virtual void Initialize(GLFWwindow* master_window = nullptr) = 0;
 #endif
 	virtual void MakeContextCurrent() = 0;
+	// Detaches the context from the calling thread so another thread can make it current.
+	virtual void ReleaseContext() = 0;
+	// Detaches whichever window's context is current on the calling thread, if any.
+	static void ReleaseCurrentContext();
+	// Pumps the event queue of every window at once; main thread only, once per frame.
+	static void PollEvents();
+	// Applies this window's input to its camera; main thread only, after PollEvents().
 	virtual void ProcessEvents() = 0;
+	// Presents the back buffer; called by whichever thread owns the context.
+	virtual void SwapBuffers() = 0;
+	// Applied on the next SwapBuffers(): 1 waits for vblank, 0 does not, -1 is adaptive (late frames tear;
+	// behaves like 1 where the driver lacks swap_control_tear). Any thread.
+	void SetSwapInterval(int interval) {
+		swap_interval_ = interval;
+	}
+
+	int GetSwapInterval() const {
+		return swap_interval_;
+	}
 	virtual void SetClearColor(const core::Color& color) = 0;
 
 	virtual void ProcessMouseMovement(double xpos, double ypos) = 0;
@@ -64,6 +86,25 @@ public:
 		nodes_3d_next_id_ = 0;
 	}
 
+	// Scene lights shade every lit material; keep the pointer to move or retune a light in place.
+	int AddLight(const std::shared_ptr<rendering::Lighting>& light) {
+		lights_[lights_next_id_] = light;
+		return lights_next_id_++;
+	}
+
+	void RemoveLight(int id) {
+		lights_.erase(id);
+	}
+
+	void ClearLights() {
+		lights_.clear();
+		lights_next_id_ = 0;
+	}
+
+	const LightsMap& GetLights() const {
+		return lights_;
+	}
+
 	const Nodes2DMap& GetNodes2D() const  {
 		return nodes_2d_;
 	}
@@ -123,9 +164,14 @@ protected:
 	wlw::scene::Nodes3DMap nodes_3d_ = {};
 	int nodes_3d_next_id_ = 0;
 
+	LightsMap lights_ = {};
+	int lights_next_id_ = 0;
+
 	std::shared_ptr<scene::Camera3D> camera_ = scene::FPSCamera::Create();
 	std::shared_ptr<rendering::WCubemap> skybox_ = nullptr;
 
+	std::atomic<int> swap_interval_ = 1;
+
 public:
 
 	static std::unique_ptr<Window> Create(const core::Vector2& size, const std::string& title);
@@ -3,14 +3,20 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <chrono>
+#include <future>
 #include <limits>
 
 #include "gltf_loader.h"
 #include "core/logger.h"
 #include "core/mesh.h"
+#include "core/mesh_optimizer.h"
+#include "core/meshlet.h"
+#include "core/mesh_simplifier.h"
 #include "core/model.h"
 #include "rendering/material.h"
 #include "rendering/texture.h"
+#include "thread_pool.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -19,23 +25,51 @@
 
 #define TINYGLTF_NO_STB_IMAGE_WRITE
 #include "tiny_gltf.h"
+#include "stb_image.h"
 #include "image_loader.h"
 
 namespace wlw::utils {
 
-  std::vector<RawImage> LoadRawImages(const tinygltf::Model& inputModel) {
-    std::vector<RawImage> raw_images;
-    for (const auto& gltfTex : inputModel.textures) {
-      const tinygltf::Image& gltfImage = inputModel.images[gltfTex.source];
-      RawImage raw;
-      raw.size = { static_cast<float>(gltfImage.width), static_cast<float>(gltfImage.height) };
-      raw.channels = gltfImage.component;
-      raw.pixels = gltfImage.image;
-      raw_images.push_back(std::move(raw));
-    }
-    return raw_images;
+  // Decodes an image tinygltf left encoded (SetImagesAsIs) straight into `out`, expanded to RGBA like
+  // tinygltf's own decoder, then frees the encoded bytes.
+  bool DecodeImage(tinygltf::Image& image, RawImage& out) {
+    int width = 0, height = 0, channels = 0;
+    unsigned char* data = image.image.empty() ? nullptr : stbi_load_from_memory(image.image.data(), (int)image.image.size(), &width, &height, &channels, 4);
+    std::vector<unsigned char>().swap(image.image);
+    if (data == nullptr) {
+      return false;
+    }
+    out.size = { static_cast<float>(width), static_cast<float>(height) };
+    out.channels = 4;
+    out.pixels.assign(data, data + (size_t)width * height * 4);
+    stbi_image_free(data);
+    return true;
   }
 
+  // Per-item import counters, summed once the parallel passes are done.
+  struct ImportStats {
+    double misses_before = 0.0, misses_after = 0.0, triangles = 0.0;
+    size_t welded = 0, lods = 0, full_triangles = 0, coarsest_triangles = 0, meshlets = 0;
+
+    void Add(const ImportStats& other) {
+      misses_before += other.misses_before;
+      misses_after += other.misses_after;
+      triangles += other.triangles;
+      welded += other.welded;
+      lods += other.lods;
+      full_triangles += other.full_triangles;
+      coarsest_triangles += other.coarsest_triangles;
+      meshlets += other.meshlets;
+    }
+  };
+
+  // A glTF mesh placed in the scene; every instance becomes its own set of baked meshes.
+  struct MeshInstance {
+    int mesh;
+    std::string name;
+    glm::mat4 transform;
+  };
+
   // Helper to extract GLM Matrix from GLTF Node
   glm::mat4 GetLocalTransform(const tinygltf::Node& node) {
     glm::mat4 matrix(1.0f);
@@ -90,6 +124,7 @@ namespace wlw::utils {
         const tinygltf::BufferView& bufferView = model.bufferViews[indexAccessor.bufferView];
         const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
         const unsigned char* dataPtr = buffer.data.data() + bufferView.byteOffset + indexAccessor.byteOffset;
+        indices.reserve(indexAccessor.count);
         if (indexAccessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
           for (size_t i = 0; i < indexAccessor.count; ++i) indices.push_back(dataPtr[i]);
         }
@@ -102,7 +137,7 @@ namespace wlw::utils {
           for (size_t i = 0; i < indexAccessor.count; ++i) indices.push_back(buf[i]);
         }
       }
-      new_mesh->SetIndices(indices);
+      new_mesh->SetIndices(std::move(indices));
       size_t vertexCount = 0;
       int posStride, normStride, texStride;
       int posType, normType, texType;
@@ -133,76 +168,192 @@ namespace wlw::utils {
         }
         vertices.push_back(v);
       }
-      new_mesh->SetVertices(vertices);
+      new_mesh->SetVertices(std::move(vertices));
       out_meshes.push_back(new_mesh);
     }
   }
 
-  void ProcessNode(const tinygltf::Model& model, const tinygltf::Node& node, const glm::mat4& parentMatrix, const std::vector<std::shared_ptr<rendering::Material>>& materials, std::vector<core::Mesh3DShared>& meshes) {
+  void CollectMeshInstances(const tinygltf::Model& model, const tinygltf::Node& node, const glm::mat4& parentMatrix, std::vector<MeshInstance>& instances) {
     glm::mat4 globalMatrix = parentMatrix * GetLocalTransform(node);
     if (node.mesh > -1) {
-      ProcessMesh(model, model.meshes[node.mesh], node.name, globalMatrix, materials, meshes);
+      instances.push_back({ node.mesh, node.name, globalMatrix });
     }
     for (int childIdx : node.children) {
-      ProcessNode(model, model.nodes[childIdx], globalMatrix, materials, meshes);
+      CollectMeshInstances(model, model.nodes[childIdx], globalMatrix, instances);
     }
   }
 
-  std::shared_ptr<core::Model<core::Vertex3D>> GLTFLoader::LoadModel(const std::string& filename, rendering::RenderDevice* device, bool normalize) {
+  std::shared_ptr<core::Model<core::Vertex3D>> GLTFLoader::LoadModel(const std::string& filename, rendering::RenderDevice* device, bool normalize, core::MeshResidency residency, bool parallel) {
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+
     tinygltf::Model model;
     tinygltf::TinyGLTF loader;
+    // Images are only read here and decoded below, next to the geometry work.
+    loader.SetImagesAsIs(true);
     std::string err, warn;
     bool ret = (filename.find(".glb") != std::string::npos) ? loader.LoadBinaryFromFile(&model, &err, &warn, filename) : loader.LoadASCIIFromFile(&model, &err, &warn, filename);
     if (!ret) return nullptr;
+    auto parsed = Clock::now();
 
-    auto raw_images = LoadRawImages(model);
-    std::vector<std::shared_ptr<rendering::WTexture>> gpu_textures;
-    for (const auto& raw : raw_images) {
-        gpu_textures.push_back(device->CreateTexture2D(raw));
+    ThreadPool& pool = ThreadPool::GetInstance();
+
+    // Each image decodes into its own slot; nothing below reads them until the textures are created.
+    std::vector<RawImage> raw_images(model.images.size());
+    std::vector<char> image_decoded(model.images.size(), 0);
+    std::vector<std::future<void>> pending_images;
+    for (size_t i = 0; i < model.images.size(); ++i) {
+      auto decode = [&model, &raw_images, &image_decoded, i]() { image_decoded[i] = DecodeImage(model.images[i], raw_images[i]); };
+      if (parallel) {
+        pending_images.push_back(pool.Submit(decode));
+      } else {
+        decode();
+      }
     }
 
+    // Textures are attached once decoded; meshes only need the material pointers.
     std::vector<std::shared_ptr<rendering::Material>> materials;
     for (const auto& gltfMat : model.materials) {
       std::shared_ptr<rendering::Material> material = rendering::Material::Create();
       material->name = gltfMat.name;
-      rendering::Lighting light_data{ .ambient_strength = 0.5f, .shininess = 32.0f };
-      if (gltfMat.pbrMetallicRoughness.baseColorFactor.size() == 4) {
-          light_data.color = { (float)gltfMat.pbrMetallicRoughness.baseColorFactor[0], (float)gltfMat.pbrMetallicRoughness.baseColorFactor[1], (float)gltfMat.pbrMetallicRoughness.baseColorFactor[2], (float)gltfMat.pbrMetallicRoughness.baseColorFactor[3] };
-      }
-      material->SetLighting(light_data);
-      int texIdx = gltfMat.pbrMetallicRoughness.baseColorTexture.index;
-      if (texIdx >= 0 && texIdx < (int)gpu_textures.size()) {
-          material->SetTexture(gpu_textures[texIdx]);
+      material->SetLit(true);
+      material->SetDoubleSided(gltfMat.doubleSided);
+      const auto& base_color = gltfMat.pbrMetallicRoughness.baseColorFactor;
+      if (base_color.size() == 4) {
+        material->base_color = { (float)base_color[0], (float)base_color[1], (float)base_color[2], (float)base_color[3] };
       }
       materials.push_back(material);
     }
 
-    std::vector<core::Mesh3DShared> meshes;
+    std::vector<MeshInstance> instances;
     const tinygltf::Scene& scene = model.scenes[model.defaultScene > -1 ? model.defaultScene : 0];
     for (int nodeIdx : scene.nodes) {
-      ProcessNode(model, model.nodes[nodeIdx], glm::mat4(1.0f), materials, meshes);
+      CollectMeshInstances(model, model.nodes[nodeIdx], glm::mat4(1.0f), instances);
+    }
+
+    // Duplicates are welded and cache, overdraw and fetch order fixed once here; nothing reorders geometry after import.
+    // Instances are independent, so each is baked on its own task; results keep scene order.
+    std::vector<std::vector<core::Mesh3DShared>> instance_meshes(instances.size());
+    std::vector<ImportStats> instance_stats(instances.size());
+    pool.ParallelFor(instances.size(), parallel ? instances.size() : 1, [&](size_t, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        const MeshInstance& instance = instances[i];
+        ProcessMesh(model, model.meshes[instance.mesh], instance.name, instance.transform, materials, instance_meshes[i]);
+        for (auto& mesh : instance_meshes[i]) {
+          instance_stats[i].welded += core::WeldMesh(*mesh);
+          double mesh_triangles = (double)(mesh->GetIndices().size() / 3);
+          core::MeshOptimizationStats stats = core::OptimizeMesh(*mesh);
+          instance_stats[i].misses_before += stats.acmr_before * mesh_triangles;
+          instance_stats[i].misses_after += stats.acmr_after * mesh_triangles;
+          instance_stats[i].triangles += mesh_triangles;
+        }
+      }
+    });
+
+    std::vector<core::Mesh3DShared> meshes;
+    ImportStats totals;
+    for (size_t i = 0; i < instances.size(); ++i) {
+      meshes.insert(meshes.end(), std::make_move_iterator(instance_meshes[i].begin()), std::make_move_iterator(instance_meshes[i].end()));
+      totals.Add(instance_stats[i]);
+    }
+    if (totals.triangles > 0.0) {
+      std::cout << "Optimized " << filename << ": ACMR " << totals.misses_before / totals.triangles << " -> " << totals.misses_after / totals.triangles << ", " << totals.welded << " duplicate vertices welded" << std::endl;
     }
 
+    glm::vec3 center(0.0f);
+    float scale = 1.0f;
     if (normalize && !meshes.empty()) {
       glm::vec3 minB(std::numeric_limits<float>::max()), maxB(std::numeric_limits<float>::lowest());
       for (const auto& mesh : meshes) {
-        for (const auto& v : mesh->GetVertices()) {
-          minB = glm::min(minB, glm::vec3(v.position.x, v.position.y, v.position.z));
-          maxB = glm::max(maxB, glm::vec3(v.position.x, v.position.y, v.position.z));
-        }
+        if (mesh->GetVertices().empty()) continue;
+        const scene::AABB& bounds = mesh->GetLocalAABB();
+        minB = glm::min(minB, glm::vec3(bounds.min.x, bounds.min.y, bounds.min.z));
+        maxB = glm::max(maxB, glm::vec3(bounds.max.x, bounds.max.y, bounds.max.z));
       }
-      glm::vec3 center = (minB + maxB) * 0.5f;
-      float scale = 1.0f / std::max({maxB.x - minB.x, maxB.y - minB.y, maxB.z - minB.z});
-      for (auto& mesh : meshes) {
-        auto vertices = mesh->GetVertices();
-        for (auto& v : vertices) {
-          v.position.x = (v.position.x - center.x) * scale;
-          v.position.y = (v.position.y - center.y) * scale;
-          v.position.z = (v.position.z - center.z) * scale;
+      center = (minB + maxB) * 0.5f;
+      scale = 1.0f / std::max({maxB.x - minB.x, maxB.y - minB.y, maxB.z - minB.z});
+    }
+
+    // LOD errors and meshlet bounds are in final mesh space, so both come after normalization. Large meshes
+    // (and LODs) are culled per cluster from here on.
+    std::vector<ImportStats> mesh_stats(meshes.size());
+    pool.ParallelFor(meshes.size(), parallel ? meshes.size() : 1, [&](size_t, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        core::Mesh<core::Vertex3D>& mesh = *meshes[i];
+        ImportStats& stats = mesh_stats[i];
+        if (normalize) {
+          mesh.EditVertices([&](std::vector<core::Vertex3D>& vertices) {
+            for (auto& v : vertices) {
+              v.position.x = (v.position.x - center.x) * scale;
+              v.position.y = (v.position.y - center.y) * scale;
+              v.position.z = (v.position.z - center.z) * scale;
+            }
+          });
+        }
+
+        stats.lods = core::GenerateLods(mesh);
+        stats.full_triangles = mesh.GetIndices().size() / 3;
+        stats.coarsest_triangles = (mesh.GetLods().empty() ? mesh.GetIndices().size() : mesh.GetLods().back().mesh->GetIndices().size()) / 3;
+
+        auto build_meshlets = [&stats](core::Mesh<core::Vertex3D>& target) {
+          if (target.GetIndices().size() / 3 >= core::kMeshletMinMeshTriangles) {
+            target.SetMeshlets(core::BuildMeshlets(target.GetVertices(), target.GetIndices()));
+            stats.meshlets += target.GetMeshlets().size();
+          }
+        };
+        build_meshlets(mesh);
+        for (const auto& lod : mesh.GetLods()) {
+          build_meshlets(*lod.mesh);
+        }
+
+        mesh.SetResidency(residency);
+        for (const auto& lod : mesh.GetLods()) {
+          lod.mesh->SetResidency(residency);
         }
-        mesh->SetVertices(vertices);
       }
+    });
+
+    totals = ImportStats();
+    for (const auto& stats : mesh_stats) {
+      totals.Add(stats);
+    }
+    if (totals.lods > 0) {
+      std::cout << "Generated " << totals.lods << " LODs for " << filename << ": " << totals.full_triangles << " -> " << totals.coarsest_triangles << " triangles at the coarsest" << std::endl;
     }
+    if (totals.meshlets > 0) {
+      std::cout << "Split " << filename << " into " << totals.meshlets << " meshlets" << std::endl;
+    }
+
+    // Textures are created on the calling thread: the device may not be usable from the workers.
+    for (auto& pending : pending_images) {
+      pending.get();
+    }
+    std::vector<std::shared_ptr<rendering::WTexture>> image_textures(raw_images.size());
+    for (size_t i = 0; i < raw_images.size(); ++i) {
+      if (!image_decoded[i]) {
+        std::cerr << "Failed to decode image " << i << " (" << model.images[i].uri << ") of " << filename << std::endl;
+        continue;
+      }
+      image_textures[i] = device->CreateTexture2D(raw_images[i]);
+      std::vector<unsigned char>().swap(raw_images[i].pixels);
+    }
+
+    // glTF textures pair an image with a sampler; several may share one image, and so one GPU texture.
+    std::vector<std::shared_ptr<rendering::WTexture>> gpu_textures;
+    for (const auto& gltfTex : model.textures) {
+      bool has_source = gltfTex.source >= 0 && gltfTex.source < (int)image_textures.size();
+      gpu_textures.push_back(has_source ? image_textures[gltfTex.source] : nullptr);
+    }
+    for (size_t i = 0; i < materials.size(); ++i) {
+      int texIdx = model.materials[i].pbrMetallicRoughness.baseColorTexture.index;
+      if (texIdx >= 0 && texIdx < (int)gpu_textures.size() && gpu_textures[texIdx]) {
+          materials[i]->SetTexture(gpu_textures[texIdx]);
+      }
+    }
+
+    auto elapsed_ms = [](Clock::time_point from, Clock::time_point to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    std::cout << "Loaded " << filename << " in " << elapsed_ms(start, Clock::now()) << " ms (parse " << elapsed_ms(start, parsed) << " ms, "
+              << raw_images.size() << " images, " << meshes.size() << " meshes, " << (parallel ? "parallel" : "serial") << ")" << std::endl;
 
     auto out = std::make_shared<core::Model<core::Vertex3D>>();
     out->textures = gpu_textures;
@@ -12,7 +12,14 @@ namespace wlw::utils {
 
 class GLTFLoader {
 public:
-  static std::shared_ptr<core::Model<core::Vertex3D>> LoadModel(const std::string& filename, rendering::RenderDevice* device, bool normalize = true);
+  // Imported meshes only live on the GPU once uploaded unless `residency` says otherwise.
+  // With `parallel`, images decode on the shared thread pool while mesh instances are baked (welded,
+  // optimized, LODs and meshlets built) as separate pool tasks; otherwise everything runs on the calling
+  // thread, which is the baseline the logged load time compares against. Textures are always created on
+  // the calling thread.
+  static std::shared_ptr<core::Model<core::Vertex3D>> LoadModel(const std::string& filename, rendering::RenderDevice* device, bool normalize = true,
+                                                                core::MeshResidency residency = core::MeshResidency::ReleaseAfterUpload,
+                                                                bool parallel = true);
 };
 
 } // namespace wlw::utils
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <limits>
+
+namespace wlw::utils {
+
+// First-fit free-list sub-allocator over a linear range of [0, capacity) units.
+// It only does bookkeeping; the owner decides what a "unit" is (vertices, indices, bytes...).
+// Adjacent free blocks are coalesced on Free so the arena does not fragment over time.
+class RangeAllocator {
+public:
+  static constexpr uint32_t kInvalidOffset = std::numeric_limits<uint32_t>::max();
+
+  explicit RangeAllocator(uint32_t capacity = 0) {
+    Reset(capacity);
+  }
+
+  void Reset(uint32_t capacity) {
+    capacity_ = capacity;
+    used_ = 0;
+    free_blocks_.clear();
+    if (capacity_ > 0) {
+      free_blocks_[0] = capacity_;
+    }
+  }
+
+  // Returns the offset of the allocated block, or kInvalidOffset when no block is large enough.
+  uint32_t Allocate(uint32_t size, uint32_t alignment = 1) {
+    if (size == 0) {
+      return kInvalidOffset;
+    }
+
+    for (auto it = free_blocks_.begin(); it != free_blocks_.end(); ++it) {
+      uint32_t block_offset = it->first;
+      uint32_t block_size = it->second;
+      uint32_t aligned = (block_offset + alignment - 1) / alignment * alignment;
+      uint32_t padding = aligned - block_offset;
+      if (block_size < size + padding) {
+        continue;
+      }
+
+      free_blocks_.erase(it);
+      if (padding > 0) {
+        free_blocks_[block_offset] = padding;
+      }
+      uint32_t remaining = block_size - padding - size;
+      if (remaining > 0) {
+        free_blocks_[aligned + size] = remaining;
+      }
+      used_ += size;
+      return aligned;
+    }
+    return kInvalidOffset;
+  }
+
+  void Free(uint32_t offset, uint32_t size) {
+    if (offset == kInvalidOffset || size == 0) {
+      return;
+    }
+    used_ -= size;
+
+    auto next = free_blocks_.lower_bound(offset);
+    // Merge with the following block.
+    if (next != free_blocks_.end() && offset + size == next->first) {
+      size += next->second;
+      next = free_blocks_.erase(next);
+    }
+    // Merge with the preceding block.
+    if (next != free_blocks_.begin()) {
+      auto prev = std::prev(next);
+      if (prev->first + prev->second == offset) {
+        prev->second += size;
+        return;
+      }
+    }
+    free_blocks_[offset] = size;
+  }
+
+  uint32_t GetCapacity() const { return capacity_; }
+  uint32_t GetUsed() const { return used_; }
+
+  uint32_t GetLargestFreeBlock() const {
+    uint32_t largest = 0;
+    for (const auto& [_, size] : free_blocks_) {
+      largest = size > largest ? size : largest;
+    }
+    return largest;
+  }
+
+private:
+  uint32_t capacity_ = 0;
+  uint32_t used_ = 0;
+  std::map<uint32_t, uint32_t> free_blocks_; // offset -> size
+};
+
+} // namespace wlw::utils
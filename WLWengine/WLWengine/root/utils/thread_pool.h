@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace wlw::utils {
+
+// Fixed set of worker threads fed from a single FIFO. Shared by the renderer and the loaders.
+class ThreadPool {
+public:
+  static ThreadPool& GetInstance() {
+    static ThreadPool instance(std::max(2u, std::thread::hardware_concurrency()) - 1);
+    return instance;
+  }
+
+  explicit ThreadPool(size_t worker_count) {
+    for (size_t i = 0; i < worker_count; ++i) {
+      workers_.emplace_back([this]() { WorkerLoop(); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    condition_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t GetWorkerCount() const {
+    return workers_.size();
+  }
+
+  template <typename F>
+  auto Submit(F&& task) -> std::future<decltype(task())> {
+    using Result = decltype(task());
+    auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+    std::future<Result> future = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.emplace([packaged]() { (*packaged)(); });
+    }
+    condition_.notify_one();
+    return future;
+  }
+
+  // Splits [0, count) into `chunks` contiguous ranges, runs chunk 0 on the calling thread and
+  // the rest on the workers, and returns once all of them are done. If any chunk throws, the first
+  // exception is rethrown, but only after every chunk has finished.
+  void ParallelFor(size_t count, size_t chunks, const std::function<void(size_t chunk, size_t begin, size_t end)>& body) {
+    if (count == 0) {
+      return;
+    }
+    chunks = std::clamp<size_t>(chunks, 1, count);
+    size_t chunk_size = (count + chunks - 1) / chunks;
+
+    std::vector<std::future<void>> pending;
+    std::exception_ptr error;
+    try {
+      for (size_t chunk = 1; chunk < chunks; ++chunk) {
+        size_t begin = chunk * chunk_size;
+        size_t end = std::min(count, begin + chunk_size);
+        if (begin >= end) {
+          break;
+        }
+        pending.push_back(Submit([&body, chunk, begin, end]() { body(chunk, begin, end); }));
+      }
+      body(0, 0, std::min(count, chunk_size));
+    }
+    catch (...) {
+      error = std::current_exception();
+    }
+
+    // Queued chunks reference `body`, so all of them are waited for before unwinding.
+    for (auto& future : pending) {
+      try {
+        future.get();
+      }
+      catch (...) {
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+private:
+  void WorkerLoop() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+        if (stopping_ && tasks_.empty()) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop();
+      }
+      task();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::queue<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stopping_ = false;
+};
+
+} // namespace wlw::utils
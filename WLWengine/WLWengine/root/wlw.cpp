@@ -1,7 +1,12 @@
 #include "wlw.h"
 
+#include <map>
+
+#include "core/logger.h"
 #include "rendering/rendering_driver.h"
 #include "rendering/render_device.h"
+#include "rendering/render_thread.h"
+#include "rendering/scene_snapshot.h"
 #include "os/input_engine.h"
 
 namespace wlw {
@@ -11,45 +16,140 @@ namespace wlw {
     WLWEngineImpl() {
         render_device_ = rendering::RenderDevice::Create();
         rendering_driver_ = rendering::RenderingDriver::Create(render_device_.get());
+        threaded_device_ = std::make_unique<rendering::ThreadedRenderDevice>(render_device_.get());
         input_engine_ = os::InputEngine::Create();
     }
 
+    ~WLWEngineImpl() override {
+      // Takes the context back so the driver and device can delete their GL objects on this thread.
+      SetThreadedRendering(false);
+    }
+
     void Start(std::shared_ptr<wlw::scene::Window> window) override {
       windows_.insert({ last_window_id, window });
       last_window_id++;
+      main_window_ = window;
+      UpdateSwapIntervals();
 			rendering_driver_->Initialize(window);
 			input_engine_->AttachWindow(window);
     }
 
     int AttachWindow(std::shared_ptr<scene::Window > window) override {
+      // Sharing a context that is current on another thread is not portable; pause the render thread.
+      bool threaded = IsThreadedRendering();
+      SetThreadedRendering(false);
 			rendering_driver_->AttachWindow(window);
+      SetThreadedRendering(threaded);
       input_engine_->AttachWindow(window);
       windows_.insert({ last_window_id, window });
+      UpdateSwapIntervals();
       return last_window_id++;
     }
 
     void Iterate() override {
+      scene::Window::PollEvents();
+
+      if (!render_thread_) {
+        for (auto& [_, window] : windows_) {
+          rendering_driver_->DrawWindow(window);
+        }
+        for (auto& [_, window] : windows_) {
+          rendering_driver_->Present(window);
+        }
+        frame_pacer_.OnPresent();
+        frame_pacer_.WaitForNextFrame();
+        return;
+      }
+
+      for (auto& [_, window] : windows_) {
+        window->ProcessEvents();
+      }
+
+      auto& frame = render_thread_->BeginFrame();
+      frame.resize(windows_.size());
+      size_t index = 0;
       for (auto& [_, window] : windows_) {
-				rendering_driver_->DrawWindow(window);
+        frame[index].window = window;
+        rendering::ExtractSceneSnapshot(*window, frame[index].snapshot);
+        index++;
+      }
+      render_thread_->SubmitFrame();
+      frame_pacer_.WaitForNextFrame();
+    }
+
+    void SetThreadedRendering(bool enabled) override {
+      if (enabled == IsThreadedRendering()) {
+        return;
+      }
+      if (FAIL_IF(main_window_ == nullptr, "threaded rendering needs a started engine")) {
+        return;
+      }
+
+      if (enabled) {
+        render_thread_ = std::make_unique<rendering::RenderThread>(rendering_driver_.get(), main_window_, &frame_pacer_);
+        main_window_->ReleaseContext();
+        render_thread_->Start();
+        threaded_device_->SetRenderThread(render_thread_.get());
+      }
+      else {
+        threaded_device_->SetRenderThread(nullptr);
+        render_thread_->Stop();
+        render_thread_ = nullptr;
       }
     }
 
+    bool IsThreadedRendering() const override {
+      return render_thread_ != nullptr;
+    }
+
+    void SetPresentMode(rendering::PresentMode mode, float target_fps) override {
+      frame_pacer_.SetMode(mode, target_fps);
+      UpdateSwapIntervals();
+    }
+
+    rendering::PresentMode GetPresentMode() const override {
+      return frame_pacer_.GetMode();
+    }
+
+    rendering::FrameTimingStats GetFrameTiming() const override {
+      return frame_pacer_.GetStats();
+    }
+
+    rendering::RenderStats GetRenderStats() const override {
+      return rendering_driver_->GetStats();
+    }
+
     rendering::RenderingDriver* GetRenderingDriver() override {
         return rendering_driver_.get();
     }
 
     rendering::RenderDevice* GetRenderDevice() override {
-        return render_device_.get();
+        return threaded_device_.get();
     }
 
 
   private:
-    std::unordered_map<int, std::shared_ptr<scene::Window>> windows_;
+    // Windows present back to back in id order; only the last one waits for the vertical blank, the
+    // others swap immediately so N windows still cost one refresh interval.
+    void UpdateSwapIntervals() {
+      for (auto& [_, window] : windows_) {
+        window->SetSwapInterval(0);
+      }
+      if (!windows_.empty()) {
+        windows_.rbegin()->second->SetSwapInterval(rendering::GetSwapInterval(frame_pacer_.GetMode()));
+      }
+    }
+
+    std::map<int, std::shared_ptr<scene::Window>> windows_; // ordered: draw and present order
+    std::shared_ptr<scene::Window> main_window_;
     int last_window_id = 0;
   
     std::unique_ptr<rendering::RenderDevice> render_device_;
     std::unique_ptr<rendering::RenderingDriver> rendering_driver_;
+    std::unique_ptr<rendering::ThreadedRenderDevice> threaded_device_;
 		std::unique_ptr<os::InputEngine> input_engine_;
+    rendering::FramePacer frame_pacer_; // outlives render_thread_, which reports presents to it
+    std::unique_ptr<rendering::RenderThread> render_thread_;
 
   };
 
@@ -6,6 +6,7 @@
 #include "scene/window.h"
 #include "rendering/rendering_driver.h"
 #include "rendering/render_device.h"
+#include "rendering/frame_pacer.h"
 
 namespace wlw {
 
@@ -17,6 +18,21 @@ namespace wlw {
 		virtual void Iterate() = 0;
 		virtual int AttachWindow(std::shared_ptr<wlw::scene::Window> window) = 0;
 
+		// When on, Iterate() only polls events and extracts a snapshot of every window; a dedicated render
+		// thread that owns the context draws it while the caller runs the next update. Call after Start().
+		virtual void SetThreadedRendering(bool enabled) = 0;
+		virtual bool IsThreadedRendering() const = 0;
+
+		// VSync by default. `target_fps` only matters for PresentMode::Capped, where Iterate() waits out the
+		// rest of each frame slot.
+		virtual void SetPresentMode(rendering::PresentMode mode, float target_fps = 60.0f) = 0;
+		virtual rendering::PresentMode GetPresentMode() const = 0;
+		// Present-to-present frame times and their jitter over the last couple of seconds.
+		virtual rendering::FrameTimingStats GetFrameTiming() const = 0;
+
+		// Per-pass GPU timings and other renderer counters; callable from the update thread.
+		virtual rendering::RenderStats GetRenderStats() const = 0;
+
 		virtual rendering::RenderingDriver* GetRenderingDriver() = 0;
 		virtual rendering::RenderDevice* GetRenderDevice() = 0;
 